@@ -0,0 +1,269 @@
+
+
+// what happens to an event queued while its type's backlog is full
+enum ESQFEventOverflow {
+	DROP_OLDEST,	// the oldest queued event makes room
+	DROP_NEWEST,	// the new event is dropped
+	COALESCE,		// the new event replaces the newest queued event with the same first argument (usually the entity)
+};
+
+// pending events and handlers of one event type
+class SQFEventQueue {
+	protected string m_Type;
+	protected ref array<ref SQFValue> m_Ring; // fixed size, m_Head is the oldest event
+	protected int m_Head;
+	protected int m_Count;
+
+	protected ref array<ref SQFCode> m_Handlers; // index is the handler id, removed handlers are null
+	protected int m_HandlerCount;
+	protected ref SQFScript m_Script; // every handler call of this type runs in it
+
+	int m_Queued;
+	int m_Dispatched;
+	int m_Dropped;
+	int m_Coalesced;
+
+	void SQFEventQueue(string type, int backlog, SQFScript script)
+	{
+		m_Type = type;
+		if(backlog < 1) backlog = 1;
+		m_Ring = new array<ref SQFValue>();
+		m_Ring.Resize(backlog);
+		m_Handlers = new array<ref SQFCode>();
+		m_Script = script;
+	}
+
+	int AddHandler(SQFCode code)
+	{
+		m_HandlerCount++;
+		return m_Handlers.Insert(code);
+	}
+	// ids aren't reused, like in game
+	bool RemoveHandler(int id)
+	{
+		if(id < 0 || id >= m_Handlers.Count() || !m_Handlers[id]) return false;
+		m_Handlers[id] = null;
+		m_HandlerCount--;
+		return true;
+	}
+	void RemoveAllHandlers()
+	{
+		for(int i = 0; i < m_Handlers.Count(); i++)
+			m_Handlers[i] = null;
+		m_HandlerCount = 0;
+		Clear();
+	}
+	bool HasHandlers()
+	{
+		return m_HandlerCount > 0;
+	}
+	int Pending()
+	{
+		return m_Count;
+	}
+	// resize the ring, at least 1. keeps the newest pending events that fit
+	void SetBacklog(int backlog)
+	{
+		if(backlog < 1) backlog = 1;
+		int capacity = m_Ring.Count();
+		int keep = m_Count;
+		if(keep > backlog) keep = backlog;
+		int skip = m_Count - keep;
+		array<ref SQFValue> ring = new array<ref SQFValue>();
+		ring.Resize(backlog);
+		for(int i = 0; i < keep; i++)
+			ring[i] = m_Ring[(m_Head + skip + i) % capacity];
+		m_Ring = ring;
+		m_Head = 0;
+		m_Count = keep;
+		m_Dropped += skip;
+	}
+
+	// returns false if the event was dropped
+	bool Push(SQFValue args, ESQFEventOverflow overflow)
+	{
+		int capacity = m_Ring.Count();
+		m_Queued++;
+		if(m_Count == capacity)
+		{
+			switch(overflow)
+			{
+				case ESQFEventOverflow.DROP_NEWEST:
+					m_Dropped++;
+					return false;
+				case ESQFEventOverflow.COALESCE:
+					int slot = findSameSource(args);
+					if(slot >= 0)
+					{
+						m_Ring[slot] = args;
+						m_Coalesced++;
+						return true;
+					}
+					break;
+			}
+			// drop the oldest
+			m_Head = (m_Head + 1) % capacity;
+			m_Count--;
+			m_Dropped++;
+		}
+		m_Ring[(m_Head + m_Count) % capacity] = args;
+		m_Count++;
+		return true;
+	}
+
+	// run every handler for the events queued so far. events queued by the handlers wait for the next frame
+	void Dispatch(SQFInterpreter vm)
+	{
+		int capacity = m_Ring.Count();
+		int pending = m_Count;
+		for(int i = 0; i < pending && m_Count > 0; i++)
+		{
+			SQFValue args = m_Ring[m_Head];
+			m_Ring[m_Head] = null;
+			m_Head = (m_Head + 1) % capacity;
+			m_Count--;
+
+			// handlers added while dispatching start with the next event
+			int handlers = m_Handlers.Count();
+			for(int id = 0; id < handlers; id++)
+			{
+				SQFCode code = m_Handlers[id];
+				if(!code) continue;
+				vm.Invoke(m_Script, code, args);
+			}
+			m_Dispatched++;
+		}
+	}
+
+	void Clear()
+	{
+		for(int i = 0; i < m_Ring.Count(); i++)
+			m_Ring[i] = null;
+		m_Head = 0;
+		m_Count = 0;
+	}
+
+	// newest queued event whose first argument equals the first argument of `args`, -1 if none
+	protected int findSameSource(SQFValue args)
+	{
+		SQFValue source = first_argument(args);
+		if(!source) return -1;
+		int capacity = m_Ring.Count();
+		for(int i = m_Count - 1; i >= 0; i--)
+		{
+			int slot = (m_Head + i) % capacity;
+			SQFValue queued = first_argument(m_Ring[slot]);
+			if(queued && queued.Equals(source)) return slot;
+		}
+		return -1;
+	}
+	protected SQFValue first_argument(SQFValue args)
+	{
+		if(!args || args.m_Type != ESQFValueType.ARRAY || args.m_Array.Count() == 0) return null;
+		return args.m_Array[0];
+	}
+}
+
+// mission event handlers (`addMissionEventHandler`).
+// game code queues events as they happen, which only costs a ring buffer write. once per frame every
+// type with pending events is dispatched: handlers were compiled when added and all calls of a type
+// reuse one script and its frame, so a firefight's worth of Fired events doesn't allocate per event.
+// a type that gets more events than its backlog drops or coalesces them instead of stalling the frame.
+class SQFEventHandlers {
+	protected SQFInterpreter m_Interpreter;
+	protected ref map<string, ref SQFEventQueue> m_Queues; // lowercase type
+	protected int m_Backlog = 256; // events per type
+	protected ESQFEventOverflow m_Overflow = ESQFEventOverflow.DROP_OLDEST;
+
+	void SQFEventHandlers(SQFInterpreter interpreter)
+	{
+		m_Interpreter = interpreter;
+		m_Queues = new map<string, ref SQFEventQueue>();
+	}
+
+	// returns the handler id
+	int Add(string type, SQFCode code)
+	{
+		return queue(type, true).AddHandler(code);
+	}
+	// compiles once, -1 if the code doesn't compile
+	int AddSource(string type, string source)
+	{
+		SQFCode code = m_Interpreter.Compile(source);
+		if(!code)
+		{
+			Print("failed to compile " + type + " event handler", LogLevel.ERROR);
+			return -1;
+		}
+		return Add(type, code);
+	}
+	bool Remove(string type, int id)
+	{
+		SQFEventQueue events = queue(type, false);
+		if(!events) return false;
+		return events.RemoveHandler(id);
+	}
+	void RemoveAll(string type)
+	{
+		SQFEventQueue events = queue(type, false);
+		if(events) events.RemoveAllHandlers();
+	}
+
+	// called by game code when an event happens. `args` becomes `_this` of the handlers.
+	// returns false if nobody listens or the event was dropped
+	bool Queue(string type, SQFValue args)
+	{
+		SQFEventQueue events = queue(type, false);
+		if(!events || !events.HasHandlers()) return false;
+		return events.Push(args, m_Overflow);
+	}
+
+	// run handlers for everything queued. called once per frame by SQFVM
+	void Dispatch()
+	{
+		for(int i = 0; i < m_Queues.Count(); i++)
+		{
+			SQFEventQueue events = m_Queues.GetElement(i);
+			if(events.Pending() > 0)
+				events.Dispatch(m_Interpreter);
+		}
+	}
+
+	// events per type, at least 1. applies to existing types too, their newest pending events are kept
+	void SetBacklog(int events)
+	{
+		if(events < 1) events = 1;
+		m_Backlog = events;
+		for(int i = 0; i < m_Queues.Count(); i++)
+			m_Queues.GetElement(i).SetBacklog(events);
+	}
+	void SetOverflow(ESQFEventOverflow overflow)
+	{
+		m_Overflow = overflow;
+	}
+
+	// "fired: 1200 queued, 1100 dispatched, 80 dropped, 20 coalesced" per type
+	string Report()
+	{
+		string report = "";
+		for(int i = 0; i < m_Queues.Count(); i++)
+		{
+			SQFEventQueue events = m_Queues.GetElement(i);
+			report += "\t" + m_Queues.GetKey(i) + ": " + events.m_Queued.ToString() + " queued, " + events.m_Dispatched.ToString() + " dispatched, "
+				+ events.m_Dropped.ToString() + " dropped, " + events.m_Coalesced.ToString() + " coalesced\n";
+		}
+		return report;
+	}
+
+	protected SQFEventQueue queue(string type, bool create)
+	{
+		string key = type;
+		key.ToLower();
+		SQFEventQueue events = m_Queues.Get(key);
+		if(events || !create) return events;
+
+		events = new SQFEventQueue(key, m_Backlog, m_Interpreter.CreatePersistentScript("eventhandler " + key));
+		m_Queues.Insert(key, events);
+		return events;
+	}
+}
@@ -0,0 +1,279 @@
+
+
+// CfgFunctions style function library.
+// names are registered immediately, code is compiled `compileFinal` in time sliced batches
+// on the call queue so a large library doesn't hitch mission start. calling a function that
+// isn't compiled yet compiles it on the spot.
+// functions compiled from resources can be hot reloaded: changed resources are found by content
+// hash and recompiled. new calls get the new code, scripts already running keep the old version
+// through their frames until they finish, then it is freed.
+class SQFFunctionLibrary {
+	protected SQFInterpreter m_Interpreter;
+
+	protected ref map<string, string> m_Sources; // pending functions registered from text
+	protected ref map<string, ResourceName> m_Resources; // pending functions registered from SQF_ScriptConfig
+	protected ref map<string, ResourceName> m_Loaded; // compiled functions that came from a resource
+	protected ref map<string, int> m_Hashes; // hash of the source a resource function was compiled from
+	protected ref array<SQFCode> m_Retired; // replaced versions, null once no script runs them
+	protected int m_Reloaded;
+	protected bool m_Watching;
+	protected int m_WatchIndex; // next m_Loaded entry the watch checks
+	protected ref array<string> m_Queue; // compile order
+	protected int m_QueueIndex;
+
+	protected int m_Registered;
+	protected int m_Compiled; // includes failures, so progress always reaches 1
+	protected int m_Failed;
+
+	protected int m_FrameBudget = 2; // milliseconds of compiling per frame
+	protected bool m_Scheduled;
+	protected ref ScriptInvoker m_OnReady;
+
+	void SQFFunctionLibrary(SQFInterpreter interpreter)
+	{
+		m_Interpreter = interpreter;
+		m_Sources = new map<string, string>();
+		m_Resources = new map<string, ResourceName>();
+		m_Loaded = new map<string, ResourceName>();
+		m_Hashes = new map<string, int>();
+		m_Retired = new array<SQFCode>();
+		m_Queue = new array<string>();
+		m_OnReady = new ScriptInvoker();
+	}
+	void ~SQFFunctionLibrary()
+	{
+		unschedule();
+		Unwatch();
+	}
+
+	// add a function by source. returns false if the name is already taken
+	bool Register(string name, string source)
+	{
+		name.ToLower();
+		if(!reserve(name)) return false;
+		m_Sources.Insert(name, source);
+		return true;
+	}
+	// add a function stored in a SQF_ScriptConfig. the resource is loaded when compiled
+	bool RegisterResource(string name, ResourceName resource)
+	{
+		name.ToLower();
+		if(!reserve(name)) return false;
+		m_Resources.Insert(name, resource);
+		return true;
+	}
+
+	// compile a pending function now. returns null if `name` isn't pending
+	SQFValue Resolve(string name)
+	{
+		if(!IsPending(name)) return null;
+		return compile(name);
+	}
+	bool IsPending(string name)
+	{
+		return m_Sources.Contains(name) || m_Resources.Contains(name);
+	}
+	// compile everything that's left without waiting for the call queue
+	void CompileAll()
+	{
+		while(m_QueueIndex < m_Queue.Count())
+		{
+			string name = m_Queue[m_QueueIndex];
+			m_QueueIndex++;
+			Resolve(name);
+		}
+		unschedule();
+	}
+
+	// fraction of registered functions compiled, 0 to 1
+	float GetProgress()
+	{
+		if(m_Registered == 0) return 1;
+		float compiled = m_Compiled;
+		return compiled / m_Registered;
+	}
+	bool IsReady()
+	{
+		return m_Compiled >= m_Registered;
+	}
+	int GetFailedCount()
+	{
+		return m_Failed;
+	}
+	// invoked every time all registered functions are compiled
+	ScriptInvoker GetOnReady()
+	{
+		return m_OnReady;
+	}
+	void SetFrameBudget(int milliseconds)
+	{
+		m_FrameBudget = milliseconds;
+	}
+
+	// --- hot reload ---
+
+	// recompile functions whose resource changed since they were compiled. returns how many.
+	// loads every resource at once, Watch() spreads the same check over frames
+	int ReloadChanged()
+	{
+		int reloaded = 0;
+		for(int i = 0; i < m_Loaded.Count(); i++)
+		{
+			if(check(i)) reloaded++;
+		}
+		return reloaded;
+	}
+	// check for changed resources every `milliseconds`. each check loads resources until the frame
+	// budget is spent and continues where it stopped next time, so a large library doesn't hitch
+	void Watch(int milliseconds)
+	{
+		Unwatch();
+		if(!GetGame()) return;
+		GetGame().GetCallQueue().CallLater(watch, milliseconds, true);
+		m_Watching = true;
+	}
+	void Unwatch()
+	{
+		if(!m_Watching) return;
+		if(GetGame()) GetGame().GetCallQueue().Remove(watch);
+		m_Watching = false;
+	}
+	// functions reloaded so far
+	int GetReloadedCount()
+	{
+		return m_Reloaded;
+	}
+	// replaced versions some script is still running
+	int GetRetiredCount()
+	{
+		for(int i = m_Retired.Count() - 1; i >= 0; i--)
+		{
+			if(!m_Retired[i]) m_Retired.Remove(i);
+		}
+		return m_Retired.Count();
+	}
+
+	protected bool reload(string name, string source)
+	{
+		SQFCode code = m_Interpreter.Compile(source, true);
+		if(!code)
+		{
+			Print("failed to reload function: " + name + ", keeping the old version", LogLevel.ERROR);
+			return false;
+		}
+		SQFNamespace missionNamespace = m_Interpreter.MissionNamespace();
+		SQFValue old = missionNamespace.Get(name);
+		if(old && old.m_Type == ESQFValueType.CODE)
+			m_Retired.Insert(old.m_Code);
+		missionNamespace.Replace(name, SQFValue.Code(code));
+		m_Interpreter.GetDebugger().Refresh(name); // keep breakpoints set in the old version
+		m_Reloaded++;
+		GetRetiredCount(); // drop versions that are gone
+		Print("reloaded function: " + name);
+		return true;
+	}
+	// reload `m_Loaded[index]` if its resource changed
+	protected bool check(int index)
+	{
+		string name = m_Loaded.GetKey(index);
+		string source = SQFVM.LoadScript(m_Loaded.GetElement(index));
+		if(source == "") return false; // failed to load, already reported
+		int hash = source.Hash();
+		if(hash == m_Hashes.Get(name)) return false;
+		m_Hashes.Set(name, hash); // a broken edit is reported once, not on every check
+		return reload(name, source);
+	}
+	protected void watch()
+	{
+		int start = System.GetTickCount();
+		int count = m_Loaded.Count();
+		for(int checked = 0; checked < count; checked++)
+		{
+			if(m_WatchIndex >= count) m_WatchIndex = 0;
+			check(m_WatchIndex);
+			m_WatchIndex++;
+			if(System.GetTickCount() - start >= m_FrameBudget) break;
+		}
+	}
+
+	protected bool reserve(string name)
+	{
+		if(IsPending(name) || m_Interpreter.MissionNamespace().Contains(name))
+		{
+			Print("function already registered: " + name, LogLevel.WARNING);
+			return false;
+		}
+		m_Queue.Insert(name);
+		m_Registered++;
+		schedule();
+		return true;
+	}
+
+	protected SQFValue compile(string name)
+	{
+		string source;
+		if(m_Sources.Find(name, source))
+		{
+			m_Sources.Remove(name);
+		}
+		else
+		{
+			ResourceName resource = m_Resources.Get(name);
+			m_Resources.Remove(name);
+			source = SQFVM.LoadScript(resource);
+			m_Loaded.Set(name, resource);
+			m_Hashes.Set(name, source.Hash());
+		}
+
+		// a resource that failed to load is empty, already reported
+		SQFCode code = null;
+		if(source != "") code = m_Interpreter.Compile(source, true);
+		m_Compiled++;
+		SQFValue value;
+		if(code)
+		{
+			// the one shared value every caller gets. final code can't be overwritten
+			value = SQFValue.Code(code);
+			m_Interpreter.MissionNamespace().Set(name, value);
+		}
+		else
+		{
+			Print("failed to compile function: " + name, LogLevel.ERROR);
+			m_Failed++;
+		}
+
+		if(IsReady())
+			m_OnReady.Invoke();
+		return value;
+	}
+
+	// compile queued functions until this frame's budget is spent
+	protected void compileBatch()
+	{
+		int start = System.GetTickCount();
+		while(m_QueueIndex < m_Queue.Count())
+		{
+			string name = m_Queue[m_QueueIndex];
+			m_QueueIndex++;
+			Resolve(name); // no-op if a call already forced it
+			if(System.GetTickCount() - start >= m_FrameBudget) break;
+		}
+		if(m_QueueIndex >= m_Queue.Count())
+			unschedule();
+	}
+
+	protected void schedule()
+	{
+		if(m_Scheduled || !GetGame()) return;
+		GetGame().GetCallQueue().CallLater(compileBatch, 0, true);
+		m_Scheduled = true;
+	}
+	protected void unschedule()
+	{
+		m_Queue.Clear();
+		m_QueueIndex = 0;
+		if(!m_Scheduled) return;
+		if(GetGame()) GetGame().GetCallQueue().Remove(compileBatch);
+		m_Scheduled = false;
+	}
+}
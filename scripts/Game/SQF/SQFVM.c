@@ -16,6 +16,9 @@ SQFVM GetScriptEngine() {
 }
 
 class SQFVM {
+	protected ref SQFInterpreter m_Interpreter;
+	protected ref SQFFunctionLibrary m_Functions;
+	protected ref SQFEventHandlers m_EventHandlers;
 	
 	// same as `LoadFile` script function
 	static string LoadScript(ResourceName res)
@@ -47,10 +50,56 @@ class SQFVM {
 	{
 		Init();
 	}
+	void ~SQFVM()
+	{
+		if(GetGame())
+			GetGame().GetCallQueue().Remove(tick);
+	}
 	
 	void Init()
 	{
+		m_Interpreter = new SQFInterpreter();
+		m_Functions = new SQFFunctionLibrary(m_Interpreter);
+		m_Interpreter.SetFunctionLibrary(m_Functions);
+		m_EventHandlers = new SQFEventHandlers(m_Interpreter);
+		m_Interpreter.SetEventHandlers(m_EventHandlers);
 		
+		// tick every frame to run spawned scripts
+		if(GetGame())
+			GetGame().GetCallQueue().CallLater(tick, 0, true);
+	}
+	
+	SQFInterpreter GetInterpreter()
+	{
+		return m_Interpreter;
+	}
+	SQFFunctionLibrary GetFunctions()
+	{
+		return m_Functions;
+	}
+	SQFEventHandlers GetEventHandlers()
+	{
+		return m_EventHandlers;
+	}
+	
+	// compile SQF text, null on syntax errors
+	SQFCode Compile(string script, bool isFinal = false)
+	{
+		return m_Interpreter.Compile(script, isFinal);
+	}
+	// compile and run unscheduled, returns the script result
+	SQFValue Execute(string script)
+	{
+		SQFCode code = Compile(script);
+		if(!code) return SQFValue.Nil();
+		return m_Interpreter.Call(code);
+	}
+	// compile and spawn, runs over the next frames
+	SQFScript Spawn(string script, SQFValue args = null)
+	{
+		SQFCode code = Compile(script);
+		if(!code) return null;
+		return m_Interpreter.Spawn(code, args);
 	}
 	
 	
@@ -67,10 +116,53 @@ class SQFVM {
 		Print("lexing test complete");
 	}
 	
+	// a called script fills its heap inside try, the limit is thrown and caught, then it allocates again
+	bool TestHeapThrow()
+	{
+		SQFInterpreter vm = new SQFInterpreter();
+		SQFScriptLimits limits = vm.GetLimits();
+		limits.m_MaxHeapBytes = 4096;
+		limits.m_HeapAction = ESQFLimitAction.THROW;
+		// the try block's array is freed by the throw, so allocating after the catch is fine
+		string source = "private _n = 0; private _caught = try { private _a = []; while {true} do { _a pushBack 'padding'; _n = count _a } } catch { _exception }; ";
+		source += "private _after = [1, 2, 3]; _after pushBack 4; [_n > 0, _caught, count _after]";
+		SQFValue result = vm.Call(vm.Compile(source));
+		bool passed = result.m_Type == ESQFValueType.ARRAY && result.m_Array[0].m_Bool && result.m_Array[2].m_Scalar == 4;
+		Print("heap throw test: " + result.Stringify() + ", expected [true,\"HEAP limit of 4096 exceeded\",4]", LogLevel.NORMAL);
+		return passed;
+	}
+	
+	// pushBack on a global array, save the changes, load them into a new interpreter
+	bool TestSnapshot(string path = "$profile:sqfvm_test.sqfs")
+	{
+		SQFInterpreter saving = new SQFInterpreter();
+		SQFSnapshotStore store = new SQFSnapshotStore(saving, saving.MissionNamespace(), path);
+		saving.Call(saving.Compile("TEST_campaign = [1]; TEST_fnc_keep = compileFinal 'true'; private _shared = [1]; TEST_a = _shared; TEST_b = [_shared];"));
+		store.SaveAll();
+		// changes in place, the shared array must mark both globals reaching it
+		saving.Call(saving.Compile("TEST_campaign pushBack 2; TEST_a pushBack 2;"));
+		store.Save();
+		
+		// the function must survive the load, it's final code the save skipped
+		SQFInterpreter loading = new SQFInterpreter();
+		loading.Call(loading.Compile("TEST_fnc_keep = compileFinal 'true';"));
+		SQFSnapshotStore loader = new SQFSnapshotStore(loading, loading.MissionNamespace(), path);
+		loader.Load();
+		SQFValue result = loading.Call(loading.Compile("[count TEST_campaign, call TEST_fnc_keep, count TEST_a, count (TEST_b select 0)]"));
+		bool passed = result.m_Type == ESQFValueType.ARRAY && result.m_Array[0].m_Scalar == 2 && result.m_Array[1].m_Bool;
+		passed = passed && result.m_Array[2].m_Scalar == 2 && result.m_Array[3].m_Scalar == 2;
+		Print("snapshot test: " + result.Stringify() + ", expected [2,true,2,2]", LogLevel.NORMAL);
+		return passed;
+	}
+	
 	protected void tick() 
 	{
 		// tick the script engine
-		// what is going to call this? should we register in GetGame().GetCallQueue	and call every 1ms ?
+		SQFFlightRecorder recorder = m_Interpreter.GetFlightRecorder();
+		recorder.BeginFrame();
+		m_EventHandlers.Dispatch();
+		m_Interpreter.Simulate();
+		recorder.EndFrame();
 	}
 }
 
@@ -0,0 +1,153 @@
+
+
+// per-script memory.
+// Enforce frees objects by reference counting, so the arena doesn't hand out raw memory. it recycles
+// the script's frames, accounts the heap the script creates (strings, arrays, frames) and releases
+// everything in one go when the script ends. values stored into globals are promoted out of it.
+class SQFArena : Managed {
+	static const int FRAME_BYTES = 64;
+	static const int VALUE_BYTES = 32;
+	static const int ELEMENT_BYTES = 8; // one array slot
+
+	// arena charged for allocations, set by the interpreter while a script runs
+	static SQFArena s_Current;
+
+	protected SQFScript m_Owner;
+	protected int m_Bytes;
+	protected int m_HighWater;
+	protected int m_Limit; // 0 for no limit
+	protected bool m_Exceeded;
+	protected bool m_Grace; // a catch block handles the limit, see BeginGrace()
+	protected bool m_GraceUnclaimed;
+	protected bool m_Tripped; // crossed the limit and hasn't dropped back under it yet
+	protected bool m_Recovered; // dropped back under the limit since it was crossed
+	protected bool m_Released;
+	protected ref array<ref SQFFrame> m_FreeFrames;
+
+	void SQFArena(SQFScript owner)
+	{
+		m_Owner = owner;
+		m_FreeFrames = new array<ref SQFFrame>();
+	}
+
+	void Charge(int bytes)
+	{
+		if(m_Released) return;
+		m_Bytes += bytes;
+		if(m_Bytes > m_HighWater)
+			m_HighWater = m_Bytes;
+		// let the interpreter deal with it before the next instruction
+		if(m_Limit > 0 && m_Bytes > Limit() && !m_Exceeded)
+		{
+			m_Exceeded = true;
+			m_Tripped = true;
+			m_Owner.Interrupt();
+		}
+	}
+	void Refund(int bytes)
+	{
+		m_Bytes -= bytes;
+		if(m_Bytes < 0) m_Bytes = 0;
+		if(m_Tripped && m_Bytes <= m_Limit)
+		{
+			m_Tripped = false;
+			m_Recovered = true;
+		}
+	}
+
+	// a code frame, recycled from an earlier scope when possible
+	SQFFrame AcquireFrame(SQFCode code, int stackBase)
+	{
+		Charge(FRAME_BYTES);
+		int pooled = m_FreeFrames.Count();
+		if(pooled == 0) return new SQFFrame(code, stackBase);
+
+		SQFFrame frame = m_FreeFrames[pooled - 1];
+		m_FreeFrames.Remove(pooled - 1);
+		frame.m_Code = code;
+		frame.m_IP = 0;
+		frame.m_StackBase = stackBase;
+		return frame;
+	}
+	void ReleaseFrame(SQFFrame frame)
+	{
+		Refund(FRAME_BYTES);
+		if(m_Released || frame.IsNative()) return;
+		frame.m_Code = null;
+		if(frame.m_Locals) frame.m_Locals.Clear();
+		m_FreeFrames.Insert(frame);
+	}
+
+	// script ended. drop pooled frames and stop accounting
+	void Release()
+	{
+		m_FreeFrames.Clear();
+		m_Bytes = 0;
+		m_Released = true;
+	}
+
+	// script finished but will be restarted. frames stay pooled for the next run
+	void Reset()
+	{
+		m_Bytes = 0;
+		m_Exceeded = false;
+		m_Grace = false;
+		m_GraceUnclaimed = false;
+		m_Tripped = false;
+		m_Recovered = false;
+	}
+
+	void SetLimit(int bytes)
+	{
+		m_Limit = bytes;
+	}
+	// the limit was hit and is thrown as an exception. the arena is still full, so the catch block gets
+	// another quarter of the limit until it returns. otherwise its own frame would hit the limit again
+	void BeginGrace()
+	{
+		m_Grace = true;
+		m_GraceUnclaimed = true;
+	}
+	// true for the try frame catching the exception. it ends the grace once its catch block returns
+	bool ClaimGrace()
+	{
+		bool claimed = m_GraceUnclaimed;
+		m_GraceUnclaimed = false;
+		return claimed;
+	}
+	void EndGrace()
+	{
+		m_Grace = false;
+	}
+	// bytes allowed right now
+	int Limit()
+	{
+		if(m_Grace) return m_Limit + m_Limit / 4;
+		return m_Limit;
+	}
+	// true if the limit was crossed since the last call
+	bool ConsumeExceeded()
+	{
+		bool exceeded = m_Exceeded;
+		m_Exceeded = false;
+		return exceeded;
+	}
+
+	// true if the script got back under the limit since it last crossed it, e.g. a thrown limit
+	// unwound what the try block built. a called script gets its chance to catch the limit back
+	bool ConsumeRecovered()
+	{
+		bool recovered = m_Recovered;
+		m_Recovered = false;
+		return recovered;
+	}
+
+	int BytesInUse()
+	{
+		return m_Bytes;
+	}
+	int HighWater()
+	{
+		return m_HighWater;
+	}
+}
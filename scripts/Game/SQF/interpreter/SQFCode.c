@@ -0,0 +1,229 @@
+
+
+// interpreter instruction set. every instruction is an opcode followed by one integer argument
+enum ESQFOpCode {
+	PUSH_NUMBER,	// push number literal 			: arg = constant index
+	PUSH_STRING,	// push string literal 			: arg = constant index
+	PUSH_BOOL,		// push `true` or `false` 		: arg = 1 or 0
+	PUSH_CODE,		// push nested code block 		: arg = block index
+	MAKE_ARRAY,		// pop N values into an array 	: arg = element count
+	GET_VAR,		// push variable value 			: arg = constant index of the name
+	SET_VAR,		// pop and assign variable 		: arg = constant index of the name
+	SET_PRIVATE,	// pop and assign private local : arg = constant index of the name
+	CALL_NULAR,		// execute nular command 		: arg = ESQFCommand
+	CALL_UNARY,		// pop right, execute 			: arg = ESQFCommand
+	CALL_BINARY,	// pop right and left, execute 	: arg = ESQFCommand
+	END_STATEMENT,	// discard the statement result : arg unused
+
+	// superinstructions, fused from common idioms by SQFOptimizer
+	INC_LOCAL,		// _i = _i + 1 					: arg = constant index of the name
+	DEC_LOCAL,		// _i = _i - 1 					: arg = constant index of the name
+	PUSHBACK_LOCAL,	// _arr pushBack <value>		: arg = constant index of the name
+	SELECT_CONST,	// <array> select N 			: arg = N
+	COUNT_LOCAL,	// count _arr 					: arg = constant index of the name
+	IS_NIL_VAR,		// isNil "var" 					: arg = constant index of the (lower case) name
+	IF_THEN,		// if <bool> then {} 			: arg = block index
+	IF_COMPARE_THEN,// if (a <op> b) then {} 		: arg = block index << 8 | ESQFCommand of the comparison
+
+	TRAP,			// breakpoint patched in by SQFDebugger : arg = breakpoint id, the original instruction is kept there
+};
+
+// compiled SQF. produced by SQFParser, executed by SQFInterpreter.
+// Managed so replaced versions can be watched with weak references, see SQFFunctionLibrary
+class SQFCode : Managed {
+	protected ref array<int> m_Instructions; // opcode, argument, opcode, argument...
+	protected ref SQFConstantPool m_Constants; // shared with nested blocks
+	protected ref array<ref SQFCode> m_Blocks; // nested `{}` blocks
+	protected string m_Source;
+	protected bool m_Final;
+	protected ref map<int, int> m_Fusions; // superinstruction -> times fused, this block and nested ones
+	protected int m_Id; // tells blocks apart in SQFFlightRecorder dumps
+	protected static int s_NextId;
+
+	// nested blocks pass the pool of the code they are in
+	void SQFCode(string source, SQFConstantPool constants = null)
+	{
+		m_Source = source;
+		s_NextId++;
+		m_Id = s_NextId;
+		m_Instructions = new array<int>();
+		m_Constants = constants;
+		if(!m_Constants) m_Constants = new SQFConstantPool();
+		m_Blocks = new array<ref SQFCode>();
+	}
+
+	int Id()
+	{
+		return m_Id;
+	}
+
+	// append an instruction
+	void Emit(ESQFOpCode op, int arg = 0)
+	{
+		m_Instructions.Insert(op);
+		m_Instructions.Insert(arg);
+	}
+	// overwrite one instruction, used by SQFDebugger
+	void Patch(int ip, ESQFOpCode op, int arg)
+	{
+		m_Instructions[ip * 2] = op;
+		m_Instructions[ip * 2 + 1] = arg;
+	}
+	// this code and all nested blocks, depth first. SQFDebugger addresses blocks by index in this order
+	void Flatten(array<SQFCode> blocks)
+	{
+		blocks.Insert(this);
+		foreach(SQFCode block : m_Blocks)
+			block.Flatten(blocks);
+	}
+	// replace all instructions, used by SQFOptimizer
+	void SetInstructions(array<int> instructions)
+	{
+		m_Instructions = instructions;
+	}
+	// pool a decoded literal or a variable name, returns the existing index if already present
+	int AddNumber(float number)
+	{
+		return m_Constants.AddNumber(number);
+	}
+	int AddString(string text)
+	{
+		return m_Constants.AddString(text);
+	}
+	int AddBlock(SQFCode block)
+	{
+		return m_Blocks.Insert(block);
+	}
+
+	// number of instructions
+	int Size()
+	{
+		return m_Instructions.Count() / 2;
+	}
+	ESQFOpCode Op(int ip)
+	{
+		return m_Instructions[ip * 2];
+	}
+	int Arg(int ip)
+	{
+		return m_Instructions[ip * 2 + 1];
+	}
+	// pooled literal value, shared by every evaluation
+	SQFValue Constant(int index)
+	{
+		return m_Constants.Get(index);
+	}
+	// variable name
+	string Name(int index)
+	{
+		return m_Constants.String(index);
+	}
+	SQFConstantPool Constants()
+	{
+		return m_Constants;
+	}
+	SQFCode Block(int index)
+	{
+		return m_Blocks[index];
+	}
+	int BlockCount()
+	{
+		return m_Blocks.Count();
+	}
+	string Source()
+	{
+		return m_Source;
+	}
+	void SetSource(string source)
+	{
+		m_Source = source;
+	}
+
+	// `compileFinal` code. shared between callers and never overwritten
+	bool IsFinal()
+	{
+		return m_Final;
+	}
+	void SetFinal(bool isFinal)
+	{
+		m_Final = isFinal;
+		foreach(SQFCode block : m_Blocks)
+			block.SetFinal(isFinal);
+	}
+
+	// superinstruction fusion counts, null if the code wasn't optimized
+	map<int, int> Fusions()
+	{
+		return m_Fusions;
+	}
+	void SetFusions(map<int, int> fusions)
+	{
+		m_Fusions = fusions;
+	}
+
+	// deep copy using `constants`, so the copy can be optimized or made final on its own
+	SQFCode CopyInto(SQFConstantPool constants)
+	{
+		SQFCode copy = new SQFCode(m_Source, constants);
+		for(int ip = 0; ip < Size(); ip++)
+		{
+			ESQFOpCode op = Op(ip);
+			int arg = Arg(ip);
+			if(UsesConstant(op))
+				arg = constants.Import(Constant(arg));
+			copy.Emit(op, arg);
+		}
+		foreach(SQFCode block : m_Blocks)
+			copy.m_Blocks.Insert(block.CopyInto(constants));
+		copy.m_Final = m_Final;
+		return copy;
+	}
+	// instructions whose argument is a constant index
+	static bool UsesConstant(ESQFOpCode op)
+	{
+		switch(op)
+		{
+			case ESQFOpCode.PUSH_NUMBER:
+			case ESQFOpCode.PUSH_STRING:
+			case ESQFOpCode.GET_VAR:
+			case ESQFOpCode.SET_VAR:
+			case ESQFOpCode.SET_PRIVATE:
+			case ESQFOpCode.INC_LOCAL:
+			case ESQFOpCode.DEC_LOCAL:
+			case ESQFOpCode.PUSHBACK_LOCAL:
+			case ESQFOpCode.COUNT_LOCAL:
+			case ESQFOpCode.IS_NIL_VAR:
+				return true;
+		}
+		return false;
+	}
+
+	// rough bytes held by this code, its nested blocks and the constant pool
+	int Footprint()
+	{
+		return block_bytes() + m_Constants.Footprint();
+	}
+
+	protected int block_bytes()
+	{
+		int bytes = m_Instructions.Count() * 4 + m_Source.Length();
+		foreach(SQFCode block : m_Blocks)
+			bytes += block.block_bytes();
+		return bytes;
+	}
+
+	// debug listing of the bytecode
+	string Disassemble(string indent = "")
+	{
+		string text = "";
+		for(int ip = 0; ip < Size(); ip++)
+		{
+			text += indent + ip.ToString() + ": " + typename.EnumToString(ESQFOpCode, Op(ip)) + " " + Arg(ip).ToString() + "\n";
+		}
+		for(int i = 0; i < m_Blocks.Count(); i++)
+		{
+			text += indent + "block " + i.ToString() + " (id " + m_Blocks[i].Id().ToString() + "):\n" + m_Blocks[i].Disassemble(indent + "\t");
+		}
+		return text;
+	}
+}
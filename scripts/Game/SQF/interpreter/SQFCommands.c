@@ -0,0 +1,852 @@
+
+
+// every command the interpreter knows. nular, unary and binary forms of the same name get separate ids
+enum ESQFCommand {
+	// nular
+	NIL,
+	TIME,
+	DIAG_TICKTIME,
+
+	// unary
+	NOT,
+	NEGATE,
+	IDENTITY,
+	DIAG_LOG,
+	HINT,
+	FORMAT,
+	STR,
+	COUNT,
+	IF,
+	WHILE,
+	FOR,
+	CALL,
+	COMPILE,
+	COMPILE_FINAL,
+	IS_NIL,
+	TYPE_NAME,
+	SLEEP,
+	WAIT_UNTIL,
+	FLOOR,
+	CEIL,
+	ROUND,
+	ABS,
+	SQRT,
+	TO_LOWER,
+	TO_UPPER,
+	SCRIPT_DONE,
+	TERMINATE,
+	PARAMS,
+	TRY,
+	THROW,
+	ADD_MISSION_EVENT_HANDLER,
+	REMOVE_MISSION_EVENT_HANDLER,
+	REMOVE_ALL_MISSION_EVENT_HANDLERS,
+	PARSE_SIMPLE_ARRAY,
+
+	// binary
+	PLUS,
+	MINUS,
+	MULTIPLY,
+	DIVIDE,
+	MODULO,
+	POWER,
+	MIN,
+	MAX,
+	ATAN2,
+	EQUAL,
+	NOT_EQUAL,
+	LESS,
+	GREATER,
+	LESS_EQUAL,
+	GREATER_EQUAL,
+	AND,
+	OR,
+	THEN,
+	ELSE,
+	DO,
+	FROM,
+	TO,
+	STEP,
+	EXIT_WITH,
+	FOR_EACH,
+	SELECT,
+	PUSH_BACK,
+	SET,
+	CALL_ARGS,
+	SPAWN,
+	COUNT_IF,
+	FIND,
+	IN,
+	APPEND,
+	CATCH,
+};
+
+// binary command precedence, higher binds tighter. unary commands bind tighter than all of these
+// https://community.bistudio.com/wiki/Operators#Order_of_Precedence
+enum ESQFPrecedence {
+	OR = 1,			// || or
+	AND,			// && and
+	COMPARISON,		// == != > < >= <=
+	BINARY,			// everything else (then, do, select, call...)
+	ELSE,			// else
+	ADDITION,		// + - min max
+	MULTIPLICATION,	// * / % mod atan2
+	POWER,			// ^
+};
+
+class SQFCommands {
+	protected ref map<string, int> m_Nular;
+	protected ref map<string, int> m_Unary;
+	protected ref map<string, int> m_Binary;
+	protected ref map<int, int> m_Precedence;
+	protected ref map<int, string> m_Names;
+	protected ref SQFSimpleArrayParser m_SimpleArrays; // created on first `parseSimpleArray`
+
+	void SQFCommands()
+	{
+		m_Nular = new map<string, int>();
+		m_Unary = new map<string, int>();
+		m_Binary = new map<string, int>();
+		m_Precedence = new map<int, int>();
+		m_Names = new map<int, string>();
+
+		InitDefaults();
+	}
+
+	// --- lookup (names are lower case) ---
+
+	bool FindNular(string name, out int id)
+	{
+		return m_Nular.Find(name, id);
+	}
+	bool FindUnary(string name, out int id)
+	{
+		return m_Unary.Find(name, id);
+	}
+	bool FindBinary(string name, out int id, out int precedence)
+	{
+		if(!m_Binary.Find(name, id)) return false;
+		precedence = m_Precedence.Get(id);
+		return true;
+	}
+	string Name(int id)
+	{
+		return m_Names.Get(id);
+	}
+
+	// --- execution ---
+	// results are pushed onto the operand stack. control structures push a frame instead,
+	// whose result lands on the stack when it returns
+
+	void ExecuteNular(SQFInterpreter vm, SQFScript script, int id)
+	{
+		switch(id)
+		{
+			case ESQFCommand.NIL:
+				script.Push(SQFValue.Nil());
+				return;
+			case ESQFCommand.TIME:
+				float time = 0;
+				if(GetGame() && GetGame().GetWorld())
+					time = GetGame().GetWorld().GetWorldTime() / 1000;
+				script.Push(SQFValue.Scalar(time));
+				return;
+			case ESQFCommand.DIAG_TICKTIME:
+				script.Push(SQFValue.Scalar(System.GetTickCount() / 1000.0));
+				return;
+		}
+		vm.RuntimeError(script, "unimplemented nular command " + Name(id));
+	}
+
+	void ExecuteUnary(SQFInterpreter vm, SQFScript script, int id, SQFValue right)
+	{
+		switch(id)
+		{
+			case ESQFCommand.NOT:
+				if(!expect(vm, script, id, right, ESQFValueType.BOOL)) return;
+				script.Push(SQFValue.Boolean(!right.m_Bool));
+				return;
+			case ESQFCommand.NEGATE:
+				if(!expect(vm, script, id, right, ESQFValueType.SCALAR)) return;
+				script.Push(SQFValue.Scalar(-right.m_Scalar));
+				return;
+			case ESQFCommand.IDENTITY:
+				script.Push(right.DeepCopy());
+				return;
+			case ESQFCommand.DIAG_LOG:
+			case ESQFCommand.HINT:
+				Print(right.Format());
+				script.Push(SQFValue.Nil());
+				return;
+			case ESQFCommand.FORMAT:
+				if(!expect(vm, script, id, right, ESQFValueType.ARRAY)) return;
+				if(right.m_Array.Count() == 0 || right.m_Array[0].m_Type != ESQFValueType.STRING)
+				{
+					vm.RuntimeError(script, "format expects a string as the first element");
+					return;
+				}
+				script.Push(SQFValue.Text(format(right.m_Array)));
+				return;
+			case ESQFCommand.STR:
+				script.Push(SQFValue.Text(right.Stringify()));
+				return;
+			case ESQFCommand.COUNT:
+				if(right.m_Type == ESQFValueType.STRING)
+				{
+					script.Push(SQFValue.Scalar(right.m_String.Length()));
+					return;
+				}
+				if(!expect(vm, script, id, right, ESQFValueType.ARRAY)) return;
+				script.Push(SQFValue.Scalar(right.m_Array.Count()));
+				return;
+			case ESQFCommand.IF:
+				if(!expect(vm, script, id, right, ESQFValueType.BOOL)) return;
+				SQFValue ifType = new SQFValue(ESQFValueType.IF);
+				ifType.m_Bool = right.m_Bool;
+				script.Push(ifType);
+				return;
+			case ESQFCommand.WHILE:
+				if(!expect(vm, script, id, right, ESQFValueType.CODE)) return;
+				SQFValue whileType = new SQFValue(ESQFValueType.WHILE);
+				whileType.m_Code = right.m_Code;
+				script.Push(whileType);
+				return;
+			case ESQFCommand.FOR:
+				if(!expect(vm, script, id, right, ESQFValueType.STRING)) return;
+				SQFValue forType = new SQFValue(ESQFValueType.FOR);
+				string variableName = right.m_String;
+				variableName.ToLower();
+				forType.m_String = variableName;
+				forType.m_Array = new array<ref SQFValue>(); // from, to, step
+				forType.m_Array.Insert(SQFValue.Scalar(0));
+				forType.m_Array.Insert(SQFValue.Scalar(0));
+				forType.m_Array.Insert(SQFValue.Scalar(1));
+				script.Push(forType);
+				return;
+			case ESQFCommand.CALL:
+				if(!expect(vm, script, id, right, ESQFValueType.CODE)) return;
+				script.PushFrame(right.m_Code);
+				return;
+			case ESQFCommand.COMPILE:
+			case ESQFCommand.COMPILE_FINAL:
+				if(!expect(vm, script, id, right, ESQFValueType.STRING)) return;
+				SQFValue compiled = vm.CompileCached(right.m_String, id == ESQFCommand.COMPILE_FINAL);
+				if(!compiled)
+				{
+					vm.RuntimeError(script, "compile failed");
+					return;
+				}
+				script.Push(compiled);
+				return;
+			case ESQFCommand.IS_NIL:
+				if(!expect(vm, script, id, right, ESQFValueType.STRING)) return;
+				string name = right.m_String;
+				name.ToLower();
+				SQFValue variable = vm.GetVariable(script, name);
+				script.Push(SQFValue.Boolean(!variable || variable.IsNil()));
+				return;
+			case ESQFCommand.TYPE_NAME:
+				script.Push(SQFValue.Text(right.TypeName()));
+				return;
+			case ESQFCommand.SLEEP:
+				if(!expect(vm, script, id, right, ESQFValueType.SCALAR)) return;
+				if(!script.IsScheduled())
+				{
+					vm.RuntimeError(script, "suspending not allowed in this context");
+					return;
+				}
+				script.Sleep(System.GetTickCount() + right.m_Scalar * 1000);
+				script.Push(SQFValue.Nil());
+				return;
+			case ESQFCommand.WAIT_UNTIL:
+				if(!expect(vm, script, id, right, ESQFValueType.CODE)) return;
+				if(!script.IsScheduled())
+				{
+					vm.RuntimeError(script, "suspending not allowed in this context");
+					return;
+				}
+				script.PushNative(new SQFWaitUntilFrame(right.m_Code));
+				return;
+			case ESQFCommand.FLOOR:
+			case ESQFCommand.CEIL:
+			case ESQFCommand.ROUND:
+			case ESQFCommand.ABS:
+			case ESQFCommand.SQRT:
+				if(!expect(vm, script, id, right, ESQFValueType.SCALAR)) return;
+				script.Push(SQFValue.Scalar(math(id, right.m_Scalar)));
+				return;
+			case ESQFCommand.TO_LOWER:
+			case ESQFCommand.TO_UPPER:
+				if(!expect(vm, script, id, right, ESQFValueType.STRING)) return;
+				string text = right.m_String;
+				if(id == ESQFCommand.TO_LOWER)
+					text.ToLower();
+				else
+					text.ToUpper();
+				script.Push(SQFValue.Text(text));
+				return;
+			case ESQFCommand.SCRIPT_DONE:
+				if(!expect(vm, script, id, right, ESQFValueType.SCRIPT)) return;
+				script.Push(SQFValue.Boolean(right.m_Script.IsDone()));
+				return;
+			case ESQFCommand.TERMINATE:
+				if(!expect(vm, script, id, right, ESQFValueType.SCRIPT)) return;
+				right.m_Script.Terminate();
+				script.Push(SQFValue.Nil());
+				return;
+			case ESQFCommand.PARAMS:
+				if(!expect(vm, script, id, right, ESQFValueType.ARRAY)) return;
+				params(vm, script, right.m_Array);
+				return;
+			case ESQFCommand.TRY:
+				if(!expect(vm, script, id, right, ESQFValueType.CODE)) return;
+				SQFValue tryType = new SQFValue(ESQFValueType.EXCEPTION);
+				tryType.m_Code = right.m_Code;
+				script.Push(tryType);
+				return;
+			case ESQFCommand.THROW:
+				vm.Throw(script, right);
+				return;
+			case ESQFCommand.ADD_MISSION_EVENT_HANDLER:
+			case ESQFCommand.REMOVE_MISSION_EVENT_HANDLER:
+				if(!expect(vm, script, id, right, ESQFValueType.ARRAY)) return;
+				if(right.m_Array.Count() < 2)
+				{
+					vm.RuntimeError(script, Name(id) + ": expected [type, code]");
+					return;
+				}
+				if(!expect(vm, script, id, right.m_Array[0], ESQFValueType.STRING)) return;
+				eventHandler(vm, script, id, right.m_Array[0].m_String, right.m_Array[1]);
+				return;
+			case ESQFCommand.REMOVE_ALL_MISSION_EVENT_HANDLERS:
+				if(!expect(vm, script, id, right, ESQFValueType.STRING)) return;
+				if(vm.EventHandlers()) vm.EventHandlers().RemoveAll(right.m_String);
+				script.Push(SQFValue.Nil());
+				return;
+			case ESQFCommand.PARSE_SIMPLE_ARRAY:
+				if(!expect(vm, script, id, right, ESQFValueType.STRING)) return;
+				if(!m_SimpleArrays) m_SimpleArrays = new SQFSimpleArrayParser();
+				SQFValue parsed = m_SimpleArrays.Parse(right.m_String);
+				if(!parsed)
+				{
+					// like in game: logged, empty array
+					Print(m_SimpleArrays.GetErrorMessage(), LogLevel.ERROR);
+					parsed = SQFValue.List();
+				}
+				script.Push(parsed);
+				return;
+		}
+		vm.RuntimeError(script, "unimplemented unary command " + Name(id));
+	}
+
+	void ExecuteBinary(SQFInterpreter vm, SQFScript script, int id, SQFValue left, SQFValue right)
+	{
+		switch(id)
+		{
+			case ESQFCommand.PLUS:
+				if(left.m_Type == ESQFValueType.STRING && right.m_Type == ESQFValueType.STRING)
+				{
+					script.Push(SQFValue.Text(left.m_String + right.m_String));
+					return;
+				}
+				if(left.m_Type == ESQFValueType.ARRAY && right.m_Type == ESQFValueType.ARRAY)
+				{
+					array<ref SQFValue> joined = new array<ref SQFValue>();
+					joined.InsertAll(left.m_Array);
+					joined.InsertAll(right.m_Array);
+					script.Push(SQFValue.List(joined));
+					return;
+				}
+				if(!expectScalars(vm, script, id, left, right)) return;
+				script.Push(SQFValue.Scalar(left.m_Scalar + right.m_Scalar));
+				return;
+			case ESQFCommand.MINUS:
+				if(left.m_Type == ESQFValueType.ARRAY && right.m_Type == ESQFValueType.ARRAY)
+				{
+					array<ref SQFValue> remaining = new array<ref SQFValue>();
+					foreach(SQFValue element : left.m_Array)
+					{
+						if(indexOf(right.m_Array, element) == -1)
+							remaining.Insert(element);
+					}
+					script.Push(SQFValue.List(remaining));
+					return;
+				}
+				if(!expectScalars(vm, script, id, left, right)) return;
+				script.Push(SQFValue.Scalar(left.m_Scalar - right.m_Scalar));
+				return;
+			case ESQFCommand.MULTIPLY:
+			case ESQFCommand.DIVIDE:
+			case ESQFCommand.MODULO:
+			case ESQFCommand.POWER:
+			case ESQFCommand.MIN:
+			case ESQFCommand.MAX:
+			case ESQFCommand.ATAN2:
+				if(!expectScalars(vm, script, id, left, right)) return;
+				if((id == ESQFCommand.DIVIDE || id == ESQFCommand.MODULO) && right.m_Scalar == 0)
+				{
+					vm.RuntimeError(script, "division by zero");
+					return;
+				}
+				script.Push(SQFValue.Scalar(arithmetic(id, left.m_Scalar, right.m_Scalar)));
+				return;
+			case ESQFCommand.EQUAL:
+				script.Push(SQFValue.Boolean(left.Equals(right)));
+				return;
+			case ESQFCommand.NOT_EQUAL:
+				script.Push(SQFValue.Boolean(!left.Equals(right)));
+				return;
+			case ESQFCommand.LESS:
+			case ESQFCommand.GREATER:
+			case ESQFCommand.LESS_EQUAL:
+			case ESQFCommand.GREATER_EQUAL:
+				if(!expectScalars(vm, script, id, left, right)) return;
+				script.Push(SQFValue.Boolean(Compare(id, left.m_Scalar, right.m_Scalar)));
+				return;
+			case ESQFCommand.AND:
+			case ESQFCommand.OR:
+				if(!expect(vm, script, id, left, ESQFValueType.BOOL)) return;
+				// `a && b` and `a || b` short circuit when the right side is code
+				if(id == ESQFCommand.AND && !left.m_Bool || id == ESQFCommand.OR && left.m_Bool)
+				{
+					script.Push(SQFValue.Boolean(left.m_Bool));
+					return;
+				}
+				if(right.m_Type == ESQFValueType.CODE)
+				{
+					script.PushFrame(right.m_Code);
+					return;
+				}
+				if(!expect(vm, script, id, right, ESQFValueType.BOOL)) return;
+				script.Push(SQFValue.Boolean(right.m_Bool));
+				return;
+			case ESQFCommand.THEN:
+				if(!expect(vm, script, id, left, ESQFValueType.IF)) return;
+				SQFCode branch;
+				if(right.m_Type == ESQFValueType.CODE)
+				{
+					if(left.m_Bool) branch = right.m_Code;
+				}
+				else if(right.m_Type == ESQFValueType.ARRAY && right.m_Array.Count() == 2)
+				{
+					int pick = 1;
+					if(left.m_Bool) pick = 0;
+					branch = right.m_Array[pick].m_Code;
+				}
+				else
+				{
+					vm.RuntimeError(script, "then expects code or [code, code], got " + right.TypeName());
+					return;
+				}
+				if(branch)
+					script.PushFrame(branch);
+				else
+					script.Push(SQFValue.Nil());
+				return;
+			case ESQFCommand.ELSE:
+				if(!expect(vm, script, id, left, ESQFValueType.CODE) || !expect(vm, script, id, right, ESQFValueType.CODE)) return;
+				SQFValue branches = SQFValue.List();
+				branches.m_Array.Insert(left);
+				branches.m_Array.Insert(right);
+				script.Push(branches);
+				return;
+			case ESQFCommand.DO:
+				if(!expect(vm, script, id, right, ESQFValueType.CODE)) return;
+				if(left.m_Type == ESQFValueType.WHILE)
+				{
+					script.PushNative(new SQFWhileFrame(left.m_Code, right.m_Code));
+					return;
+				}
+				if(left.m_Type == ESQFValueType.FOR)
+				{
+					script.PushNative(new SQFForFrame(left.m_String, left.m_Array[0].m_Scalar, left.m_Array[1].m_Scalar, left.m_Array[2].m_Scalar, right.m_Code));
+					return;
+				}
+				vm.RuntimeError(script, "do expects while or for, got " + left.TypeName());
+				return;
+			case ESQFCommand.FROM:
+			case ESQFCommand.TO:
+			case ESQFCommand.STEP:
+				if(!expect(vm, script, id, left, ESQFValueType.FOR) || !expect(vm, script, id, right, ESQFValueType.SCALAR)) return;
+				int slot = id - ESQFCommand.FROM;
+				left.m_Array[slot] = right;
+				script.Push(left);
+				return;
+			case ESQFCommand.EXIT_WITH:
+				if(!expect(vm, script, id, left, ESQFValueType.IF) || !expect(vm, script, id, right, ESQFValueType.CODE)) return;
+				if(left.m_Bool)
+					script.PushNative(new SQFExitWithFrame(right.m_Code));
+				else
+					script.Push(SQFValue.Nil());
+				return;
+			case ESQFCommand.FOR_EACH:
+				if(!expect(vm, script, id, left, ESQFValueType.CODE) || !expect(vm, script, id, right, ESQFValueType.ARRAY)) return;
+				script.PushNative(new SQFForEachFrame(left.m_Code, right.m_Array));
+				return;
+			case ESQFCommand.COUNT_IF:
+				if(!expect(vm, script, id, left, ESQFValueType.CODE) || !expect(vm, script, id, right, ESQFValueType.ARRAY)) return;
+				script.PushNative(new SQFCountFrame(left.m_Code, right.m_Array));
+				return;
+			case ESQFCommand.CATCH:
+				if(!expect(vm, script, id, left, ESQFValueType.EXCEPTION) || !expect(vm, script, id, right, ESQFValueType.CODE)) return;
+				script.PushNative(new SQFTryFrame(left.m_Code, right.m_Code));
+				return;
+			case ESQFCommand.SELECT:
+				if(!expect(vm, script, id, left, ESQFValueType.ARRAY)) return;
+				int index;
+				if(right.m_Type == ESQFValueType.BOOL)
+				{
+					if(right.m_Bool) index = 1;
+				}
+				else
+				{
+					if(!expect(vm, script, id, right, ESQFValueType.SCALAR)) return;
+					index = Math.Round(right.m_Scalar);
+				}
+				script.Push(Select(left.m_Array, index));
+				return;
+			case ESQFCommand.PUSH_BACK:
+				if(!expect(vm, script, id, left, ESQFValueType.ARRAY)) return;
+				left.Changed(right);
+				left.Account(SQFArena.ELEMENT_BYTES);
+				script.Push(SQFValue.Scalar(left.m_Array.Insert(right)));
+				return;
+			case ESQFCommand.SET:
+				if(!expect(vm, script, id, left, ESQFValueType.ARRAY) || !expect(vm, script, id, right, ESQFValueType.ARRAY)) return;
+				if(right.m_Array.Count() != 2 || right.m_Array[0].m_Type != ESQFValueType.SCALAR)
+				{
+					vm.RuntimeError(script, "set expects [index, value]");
+					return;
+				}
+				int setIndex = Math.Round(right.m_Array[0].m_Scalar);
+				if(setIndex < 0)
+				{
+					vm.RuntimeError(script, "set index out of range");
+					return;
+				}
+				if(left.m_Array.Count() <= setIndex)
+					left.Account((setIndex + 1 - left.m_Array.Count()) * SQFArena.ELEMENT_BYTES);
+				while(left.m_Array.Count() <= setIndex)
+					left.m_Array.Insert(SQFValue.Nil());
+				left.Changed(right.m_Array[1]);
+				left.m_Array[setIndex] = right.m_Array[1];
+				script.Push(SQFValue.Nil());
+				return;
+			case ESQFCommand.CALL_ARGS:
+				if(!expect(vm, script, id, right, ESQFValueType.CODE)) return;
+				SQFFrame frame = script.PushFrame(right.m_Code);
+				frame.SetLocal("_this", left);
+				return;
+			case ESQFCommand.SPAWN:
+				if(!expect(vm, script, id, right, ESQFValueType.CODE)) return;
+				SQFValue handle = new SQFValue(ESQFValueType.SCRIPT);
+				handle.m_Script = vm.Spawn(right.m_Code, left, script.Name());
+				script.Push(handle);
+				return;
+			case ESQFCommand.FIND:
+				if(left.m_Type == ESQFValueType.STRING)
+				{
+					if(!expect(vm, script, id, right, ESQFValueType.STRING)) return;
+					script.Push(SQFValue.Scalar(left.m_String.IndexOf(right.m_String)));
+					return;
+				}
+				if(!expect(vm, script, id, left, ESQFValueType.ARRAY)) return;
+				script.Push(SQFValue.Scalar(indexOf(left.m_Array, right)));
+				return;
+			case ESQFCommand.IN:
+				if(!expect(vm, script, id, right, ESQFValueType.ARRAY)) return;
+				script.Push(SQFValue.Boolean(indexOf(right.m_Array, left) != -1));
+				return;
+			case ESQFCommand.APPEND:
+				if(!expect(vm, script, id, left, ESQFValueType.ARRAY) || !expect(vm, script, id, right, ESQFValueType.ARRAY)) return;
+				left.Account(right.m_Array.Count() * SQFArena.ELEMENT_BYTES);
+				foreach(SQFValue appended : right.m_Array)
+					left.Changed(appended);
+				left.m_Array.InsertAll(right.m_Array);
+				script.Push(SQFValue.Nil());
+				return;
+		}
+		vm.RuntimeError(script, "unimplemented binary command " + Name(id));
+	}
+
+	// `array select index`. out of range reads return nil
+	static SQFValue Select(array<ref SQFValue> values, int index)
+	{
+		if(index < 0 || index >= values.Count()) return SQFValue.Nil();
+		return values[index];
+	}
+
+	// comparison commands on numbers
+	static bool Compare(int id, float a, float b)
+	{
+		switch(id)
+		{
+			case ESQFCommand.EQUAL:
+				return a == b;
+			case ESQFCommand.NOT_EQUAL:
+				return a != b;
+			case ESQFCommand.LESS:
+				return a < b;
+			case ESQFCommand.GREATER:
+				return a > b;
+			case ESQFCommand.LESS_EQUAL:
+				return a <= b;
+			case ESQFCommand.GREATER_EQUAL:
+				return a >= b;
+		}
+		return false;
+	}
+
+	// --- helpers ---
+
+	protected bool expect(SQFInterpreter vm, SQFScript script, int id, SQFValue value, ESQFValueType type)
+	{
+		if(value.m_Type == type) return true;
+		vm.RuntimeError(script, Name(id) + ": type " + value.TypeName() + ", expected " + typename.EnumToString(ESQFValueType, type));
+		return false;
+	}
+	// addMissionEventHandler [type, code] and removeMissionEventHandler [type, id]
+	protected void eventHandler(SQFInterpreter vm, SQFScript script, int id, string type, SQFValue argument)
+	{
+		SQFEventHandlers handlers = vm.EventHandlers();
+		if(!handlers)
+		{
+			vm.RuntimeError(script, Name(id) + ": no event handlers in this context");
+			return;
+		}
+		if(id == ESQFCommand.REMOVE_MISSION_EVENT_HANDLER)
+		{
+			if(!expect(vm, script, id, argument, ESQFValueType.SCALAR)) return;
+			handlers.Remove(type, argument.m_Scalar);
+			script.Push(SQFValue.Nil());
+			return;
+		}
+		// strings are compiled here, once
+		int handler = -1;
+		if(argument.m_Type == ESQFValueType.CODE)
+			handler = handlers.Add(type, argument.m_Code);
+		else if(expect(vm, script, id, argument, ESQFValueType.STRING))
+			handler = handlers.AddSource(type, argument.m_String);
+		else
+			return;
+		script.Push(SQFValue.Scalar(handler));
+	}
+	protected bool expectScalars(SQFInterpreter vm, SQFScript script, int id, SQFValue left, SQFValue right)
+	{
+		return expect(vm, script, id, left, ESQFValueType.SCALAR) && expect(vm, script, id, right, ESQFValueType.SCALAR);
+	}
+	protected int indexOf(array<ref SQFValue> values, SQFValue value)
+	{
+		for(int i = 0; i < values.Count(); i++)
+		{
+			if(values[i].Equals(value)) return i;
+		}
+		return -1;
+	}
+	protected float math(int id, float value)
+	{
+		switch(id)
+		{
+			case ESQFCommand.FLOOR:
+				return Math.Floor(value);
+			case ESQFCommand.CEIL:
+				return Math.Ceil(value);
+			case ESQFCommand.ROUND:
+				return Math.Round(value);
+			case ESQFCommand.ABS:
+				return Math.AbsFloat(value);
+			case ESQFCommand.SQRT:
+				return Math.Sqrt(value);
+		}
+		return value;
+	}
+	protected float arithmetic(int id, float a, float b)
+	{
+		switch(id)
+		{
+			case ESQFCommand.MULTIPLY:
+				return a * b;
+			case ESQFCommand.DIVIDE:
+				return a / b;
+			case ESQFCommand.MODULO:
+				return Math.ModFloat(a, b);
+			case ESQFCommand.POWER:
+				return Math.Pow(a, b);
+			case ESQFCommand.MIN:
+				return Math.Min(a, b);
+			case ESQFCommand.MAX:
+				return Math.Max(a, b);
+			case ESQFCommand.ATAN2:
+				return Math.Atan2(a, b) * Math.RAD2DEG;
+		}
+		return 0;
+	}
+	// format ["text %1 %2", a, b]
+	protected string format(array<ref SQFValue> args)
+	{
+		string pattern = args[0].m_String;
+		string result = "";
+		int len = pattern.Length();
+		int i = 0;
+		while(i < len)
+		{
+			string c = pattern.Get(i);
+			if(c == "%")
+			{
+				int j = i + 1;
+				while(j < len && is_digit(pattern.Get(j))) j++;
+				if(j > i + 1)
+				{
+					int arg = pattern.Substring(i + 1, j - i - 1).ToInt();
+					if(arg < args.Count())
+						result += args[arg].Format();
+					i = j;
+					continue;
+				}
+			}
+			result += c;
+			i++;
+		}
+		return result;
+	}
+	protected bool is_digit(string c)
+	{
+		int ascii = c.ToAscii();
+		return ascii >= 48 && ascii <= 57;
+	}
+	// params ["_a", ["_b", default]] reading from `_this`
+	protected void params(SQFInterpreter vm, SQFScript script, array<ref SQFValue> names)
+	{
+		SQFValue args = script.GetLocal("_this");
+		if(!args) args = SQFValue.Nil();
+		for(int i = 0; i < names.Count(); i++)
+		{
+			SQFValue spec = names[i];
+			SQFValue defaultValue = SQFValue.Nil();
+			if(spec.m_Type == ESQFValueType.ARRAY && spec.m_Array.Count() > 0)
+			{
+				if(spec.m_Array.Count() > 1) defaultValue = spec.m_Array[1];
+				spec = spec.m_Array[0];
+			}
+			if(spec.m_Type != ESQFValueType.STRING)
+			{
+				vm.RuntimeError(script, "params expects variable names");
+				return;
+			}
+			SQFValue value;
+			if(args.m_Type == ESQFValueType.ARRAY)
+				value = Select(args.m_Array, i);
+			else if(i == 0)
+				value = args;
+			if(!value || value.IsNil()) value = defaultValue;
+			string name = spec.m_String;
+			name.ToLower();
+			script.SetPrivate(name, value);
+		}
+		script.Push(SQFValue.Boolean(true));
+	}
+
+	// --- registration ---
+
+	protected void RegisterNular(string name, ESQFCommand id)
+	{
+		m_Nular.Insert(name, id);
+		m_Names.Set(id, name);
+	}
+	protected void RegisterUnary(string name, ESQFCommand id)
+	{
+		m_Unary.Insert(name, id);
+		m_Names.Set(id, name);
+	}
+	protected void RegisterBinary(string name, ESQFCommand id, ESQFPrecedence precedence = ESQFPrecedence.BINARY)
+	{
+		m_Binary.Insert(name, id);
+		m_Precedence.Set(id, precedence);
+		m_Names.Set(id, name);
+	}
+
+	// https://community.bistudio.com/wiki/Category:Arma_3:_Scripting_Commands
+	protected void InitDefaults()
+	{
+		RegisterNular("nil", ESQFCommand.NIL);
+		RegisterNular("time", ESQFCommand.TIME);
+		RegisterNular("diag_ticktime", ESQFCommand.DIAG_TICKTIME);
+
+		RegisterUnary("!", ESQFCommand.NOT);
+		RegisterUnary("not", ESQFCommand.NOT);
+		RegisterUnary("-", ESQFCommand.NEGATE);
+		RegisterUnary("+", ESQFCommand.IDENTITY);
+		RegisterUnary("diag_log", ESQFCommand.DIAG_LOG);
+		RegisterUnary("hint", ESQFCommand.HINT);
+		RegisterUnary("systemchat", ESQFCommand.HINT);
+		RegisterUnary("format", ESQFCommand.FORMAT);
+		RegisterUnary("str", ESQFCommand.STR);
+		RegisterUnary("count", ESQFCommand.COUNT);
+		RegisterUnary("if", ESQFCommand.IF);
+		RegisterUnary("while", ESQFCommand.WHILE);
+		RegisterUnary("for", ESQFCommand.FOR);
+		RegisterUnary("call", ESQFCommand.CALL);
+		RegisterUnary("compile", ESQFCommand.COMPILE);
+		RegisterUnary("compilefinal", ESQFCommand.COMPILE_FINAL);
+		RegisterUnary("isnil", ESQFCommand.IS_NIL);
+		RegisterUnary("typename", ESQFCommand.TYPE_NAME);
+		RegisterUnary("sleep", ESQFCommand.SLEEP);
+		RegisterUnary("uisleep", ESQFCommand.SLEEP);
+		RegisterUnary("waituntil", ESQFCommand.WAIT_UNTIL);
+		RegisterUnary("floor", ESQFCommand.FLOOR);
+		RegisterUnary("ceil", ESQFCommand.CEIL);
+		RegisterUnary("round", ESQFCommand.ROUND);
+		RegisterUnary("abs", ESQFCommand.ABS);
+		RegisterUnary("sqrt", ESQFCommand.SQRT);
+		RegisterUnary("tolower", ESQFCommand.TO_LOWER);
+		RegisterUnary("toupper", ESQFCommand.TO_UPPER);
+		RegisterUnary("scriptdone", ESQFCommand.SCRIPT_DONE);
+		RegisterUnary("terminate", ESQFCommand.TERMINATE);
+		RegisterUnary("params", ESQFCommand.PARAMS);
+		RegisterUnary("try", ESQFCommand.TRY);
+		RegisterUnary("throw", ESQFCommand.THROW);
+		RegisterUnary("addmissioneventhandler", ESQFCommand.ADD_MISSION_EVENT_HANDLER);
+		RegisterUnary("removemissioneventhandler", ESQFCommand.REMOVE_MISSION_EVENT_HANDLER);
+		RegisterUnary("removeallmissioneventhandlers", ESQFCommand.REMOVE_ALL_MISSION_EVENT_HANDLERS);
+		RegisterUnary("parsesimplearray", ESQFCommand.PARSE_SIMPLE_ARRAY);
+
+		RegisterBinary("||", ESQFCommand.OR, ESQFPrecedence.OR);
+		RegisterBinary("or", ESQFCommand.OR, ESQFPrecedence.OR);
+		RegisterBinary("&&", ESQFCommand.AND, ESQFPrecedence.AND);
+		RegisterBinary("and", ESQFCommand.AND, ESQFPrecedence.AND);
+		RegisterBinary("==", ESQFCommand.EQUAL, ESQFPrecedence.COMPARISON);
+		RegisterBinary("!=", ESQFCommand.NOT_EQUAL, ESQFPrecedence.COMPARISON);
+		RegisterBinary("<", ESQFCommand.LESS, ESQFPrecedence.COMPARISON);
+		RegisterBinary(">", ESQFCommand.GREATER, ESQFPrecedence.COMPARISON);
+		RegisterBinary("<=", ESQFCommand.LESS_EQUAL, ESQFPrecedence.COMPARISON);
+		RegisterBinary(">=", ESQFCommand.GREATER_EQUAL, ESQFPrecedence.COMPARISON);
+		RegisterBinary("else", ESQFCommand.ELSE, ESQFPrecedence.ELSE);
+		RegisterBinary("+", ESQFCommand.PLUS, ESQFPrecedence.ADDITION);
+		RegisterBinary("-", ESQFCommand.MINUS, ESQFPrecedence.ADDITION);
+		RegisterBinary("min", ESQFCommand.MIN, ESQFPrecedence.ADDITION);
+		RegisterBinary("max", ESQFCommand.MAX, ESQFPrecedence.ADDITION);
+		RegisterBinary("*", ESQFCommand.MULTIPLY, ESQFPrecedence.MULTIPLICATION);
+		RegisterBinary("/", ESQFCommand.DIVIDE, ESQFPrecedence.MULTIPLICATION);
+		RegisterBinary("%", ESQFCommand.MODULO, ESQFPrecedence.MULTIPLICATION);
+		RegisterBinary("mod", ESQFCommand.MODULO, ESQFPrecedence.MULTIPLICATION);
+		RegisterBinary("atan2", ESQFCommand.ATAN2, ESQFPrecedence.MULTIPLICATION);
+		RegisterBinary("^", ESQFCommand.POWER, ESQFPrecedence.POWER);
+		RegisterBinary("then", ESQFCommand.THEN);
+		RegisterBinary("do", ESQFCommand.DO);
+		RegisterBinary("from", ESQFCommand.FROM);
+		RegisterBinary("to", ESQFCommand.TO);
+		RegisterBinary("step", ESQFCommand.STEP);
+		RegisterBinary("exitwith", ESQFCommand.EXIT_WITH);
+		RegisterBinary("foreach", ESQFCommand.FOR_EACH);
+		RegisterBinary("select", ESQFCommand.SELECT);
+		RegisterBinary("pushback", ESQFCommand.PUSH_BACK);
+		RegisterBinary("set", ESQFCommand.SET);
+		RegisterBinary("call", ESQFCommand.CALL_ARGS);
+		RegisterBinary("spawn", ESQFCommand.SPAWN);
+		RegisterBinary("count", ESQFCommand.COUNT_IF);
+		RegisterBinary("find", ESQFCommand.FIND);
+		RegisterBinary("in", ESQFCommand.IN);
+		RegisterBinary("append", ESQFCommand.APPEND);
+		RegisterBinary("catch", ESQFCommand.CATCH);
+	}
+}
@@ -0,0 +1,164 @@
+
+
+class SQFCompileCacheEntry {
+	string m_Source;
+	bool m_Final;
+	ref SQFValue m_Value;
+	int m_Hash;
+	int m_Bytes;
+	bool m_Referenced; // hit since the clock hand last passed
+	SQFCompileCacheEntry m_Next; // same hash
+}
+
+// cache for the `compile` command.
+// `call compile format [...]` builds the same few strings over and over. entries are keyed by the
+// string hash and the source is compared on a hit, so a collision is a miss, never wrong code.
+// code is immutable once compiled, so every caller shares one value. the cache is bounded in bytes
+// and evicts with the clock algorithm: recently hit entries get a second chance.
+class SQFCompileCache {
+	protected ref array<ref SQFCompileCacheEntry> m_Entries; // owns the entries, clock order
+	protected ref map<int, SQFCompileCacheEntry> m_Buckets; // hash -> first entry
+	protected int m_Hand;
+
+	protected int m_Limit = 1024 * 1024; // bytes, 0 disables the cache
+	protected int m_Bytes;
+	protected int m_Hits;
+	protected int m_Misses;
+	protected int m_Evictions;
+
+	void SQFCompileCache()
+	{
+		m_Entries = new array<ref SQFCompileCacheEntry>();
+		m_Buckets = new map<int, SQFCompileCacheEntry>();
+	}
+
+	// the shared code value for `source`, null on a miss
+	SQFValue Find(string source, bool isFinal)
+	{
+		int hash = source.Hash();
+		SQFCompileCacheEntry entry = m_Buckets.Get(hash);
+		while(entry)
+		{
+			if(entry.m_Final == isFinal && entry.m_Source == source)
+			{
+				entry.m_Referenced = true;
+				m_Hits++;
+				return entry.m_Value;
+			}
+			entry = entry.m_Next;
+		}
+		m_Misses++;
+		return null;
+	}
+
+	// cache freshly compiled code. returns the value to hand out
+	SQFValue Insert(string source, bool isFinal, SQFCode code)
+	{
+		SQFValue value = SQFValue.Code(code);
+		value.Promote(); // shared by every script, not owned by the one that compiled it
+		int bytes = source.Length() + code.Footprint();
+		if(bytes > m_Limit) return value;
+
+		SQFCompileCacheEntry entry = new SQFCompileCacheEntry();
+		entry.m_Source = source;
+		entry.m_Final = isFinal;
+		entry.m_Value = value;
+		entry.m_Hash = source.Hash();
+		entry.m_Bytes = bytes;
+		entry.m_Next = m_Buckets.Get(entry.m_Hash);
+		m_Buckets.Set(entry.m_Hash, entry);
+		m_Entries.Insert(entry);
+		m_Bytes += bytes;
+		trim();
+		return value;
+	}
+
+	void SetLimit(int bytes)
+	{
+		m_Limit = bytes;
+		trim();
+	}
+	void Clear()
+	{
+		m_Entries.Clear();
+		m_Buckets.Clear();
+		m_Hand = 0;
+		m_Bytes = 0;
+	}
+
+	int Count()
+	{
+		return m_Entries.Count();
+	}
+	int BytesInUse()
+	{
+		return m_Bytes;
+	}
+	int Limit()
+	{
+		return m_Limit;
+	}
+	// fraction of lookups that hit, 0 to 1
+	float HitRate()
+	{
+		int lookups = m_Hits + m_Misses;
+		if(lookups == 0) return 0;
+		float hits = m_Hits;
+		return hits / lookups;
+	}
+	int Hits()
+	{
+		return m_Hits;
+	}
+	int Misses()
+	{
+		return m_Misses;
+	}
+	int Evictions()
+	{
+		return m_Evictions;
+	}
+	string Report()
+	{
+		return Count().ToString() + " entries, " + m_Bytes.ToString() + "/" + m_Limit.ToString() + " bytes, hit rate " + HitRate().ToString()
+			+ " (" + m_Hits.ToString() + " hits, " + m_Misses.ToString() + " misses, " + m_Evictions.ToString() + " evictions)";
+	}
+
+	// evict until under the limit
+	protected void trim()
+	{
+		while(m_Bytes > m_Limit && m_Entries.Count() > 0)
+		{
+			if(m_Hand >= m_Entries.Count()) m_Hand = 0;
+			SQFCompileCacheEntry entry = m_Entries[m_Hand];
+			if(entry.m_Referenced)
+			{
+				entry.m_Referenced = false;
+				m_Hand++;
+				continue;
+			}
+			unlink(entry);
+			m_Bytes -= entry.m_Bytes;
+			m_Evictions++;
+			// the last entry takes the evicted slot, the hand looks at it next
+			int last = m_Entries.Count() - 1;
+			m_Entries[m_Hand] = m_Entries[last];
+			m_Entries.Remove(last);
+		}
+	}
+	protected void unlink(SQFCompileCacheEntry entry)
+	{
+		SQFCompileCacheEntry head = m_Buckets.Get(entry.m_Hash);
+		if(head == entry)
+		{
+			if(entry.m_Next)
+				m_Buckets.Set(entry.m_Hash, entry.m_Next);
+			else
+				m_Buckets.Remove(entry.m_Hash);
+			return;
+		}
+		while(head && head.m_Next != entry)
+			head = head.m_Next;
+		if(head) head.m_Next = entry.m_Next;
+	}
+}
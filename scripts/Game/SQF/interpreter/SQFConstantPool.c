@@ -0,0 +1,83 @@
+
+
+// literals and variable names of one script, shared by all its nested blocks.
+// the lexer decodes literals once, the pool keeps one value per distinct number or string and
+// instructions refer to them by index. pushing a literal pushes the pooled value, values are
+// never modified in place so every evaluation can share it.
+class SQFConstantPool {
+	protected ref array<ref SQFValue> m_Values;
+	protected ref map<string, int> m_Strings; // text -> index
+	protected ref map<int, ref array<int>> m_Numbers; // bucket key -> pool indices, see numberKey()
+	protected int m_Bytes;
+
+	void SQFConstantPool()
+	{
+		m_Values = new array<ref SQFValue>();
+		m_Strings = new map<string, int>();
+		m_Numbers = new map<int, ref array<int>>();
+	}
+
+	int AddNumber(float number)
+	{
+		int key = numberKey(number);
+		array<int> bucket = m_Numbers.Get(key);
+		if(!bucket)
+		{
+			bucket = new array<int>();
+			m_Numbers.Insert(key, bucket);
+		}
+		foreach(int pooled : bucket)
+		{
+			if(m_Values[pooled].m_Scalar == number) return pooled;
+		}
+		int index = add(SQFValue.Scalar(number), SQFArena.VALUE_BYTES);
+		bucket.Insert(index);
+		return index;
+	}
+	// string literals and variable names
+	int AddString(string text)
+	{
+		int index;
+		if(m_Strings.Find(text, index)) return index;
+		index = add(SQFValue.Text(text), SQFArena.VALUE_BYTES + text.Length());
+		m_Strings.Insert(text, index);
+		return index;
+	}
+	// copy a constant from another pool
+	int Import(SQFValue value)
+	{
+		if(value.m_Type == ESQFValueType.SCALAR) return AddNumber(value.m_Scalar);
+		return AddString(value.m_String);
+	}
+
+	SQFValue Get(int index)
+	{
+		return m_Values[index];
+	}
+	string String(int index)
+	{
+		return m_Values[index].m_String;
+	}
+	int Count()
+	{
+		return m_Values.Count();
+	}
+	int Footprint()
+	{
+		return m_Bytes;
+	}
+
+	// floats can't key a map exactly, so numbers are bucketed by their value in sixteenths and
+	// compared exactly within the bucket. literals are mostly integers, one number per bucket
+	protected int numberKey(float number)
+	{
+		int key = number * 16;
+		return key;
+	}
+	protected int add(SQFValue value, int bytes)
+	{
+		value.Promote(); // belongs to the code, not to the script that happens to compile it
+		m_Bytes += bytes;
+		return m_Values.Insert(value);
+	}
+}
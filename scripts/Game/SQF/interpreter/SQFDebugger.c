@@ -0,0 +1,247 @@
+
+
+class SQFBreakpoint {
+	int m_Id;
+	string m_Function; // lowercase global holding the code
+	int m_Block; // index in SQFCode.Flatten() order, 0 is the function body
+	int m_IP;
+	SQFCode m_Code; // the patched block
+	ESQFOpCode m_Op; // instruction the trap replaced
+	int m_Arg;
+	int m_Hits;
+}
+
+// breakpoints and stepping for scheduled scripts.
+// a breakpoint doesn't add a check to the interpreter loop: the function gets a private copy of its
+// code with a TRAP instruction patched over the target, the replaced instruction is kept here.
+// code without breakpoints runs exactly as before. a scheduled script pauses on a trap, called
+// scripts can't be suspended so they only report the hit. stepping raises the interrupt flag of the
+// one script being stepped, so only that script is looked at before every instruction.
+class SQFDebugger {
+	protected SQFInterpreter m_Interpreter;
+	protected ref array<ref SQFBreakpoint> m_Breakpoints; // index is the breakpoint id, removed ones are null
+	protected ref map<string, ref SQFValue> m_Originals; // function -> its code before patching
+	protected ref map<string, ref SQFValue> m_Patched; // function -> the patched copy
+	protected ref ScriptInvoker m_OnBreak; // (SQFScript script, SQFBreakpoint breakpoint), null after a step
+
+	void SQFDebugger(SQFInterpreter interpreter)
+	{
+		m_Interpreter = interpreter;
+		m_Breakpoints = new array<ref SQFBreakpoint>();
+		m_Originals = new map<string, ref SQFValue>();
+		m_Patched = new map<string, ref SQFValue>();
+		m_OnBreak = new ScriptInvoker();
+	}
+
+	// break before instruction `ip` of `block` in the function stored in global `name`.
+	// scripts already running the function keep running the unpatched code. returns the id or -1
+	int SetBreakpoint(string name, int block = 0, int ip = 0)
+	{
+		string function = name;
+		function.ToLower();
+		SQFValue patched = patch(function);
+		if(!patched) return -1;
+
+		array<SQFCode> blocks = new array<SQFCode>();
+		patched.m_Code.Flatten(blocks);
+		if(block < 0 || block >= blocks.Count() || ip < 0 || ip >= blocks[block].Size())
+		{
+			Print("no instruction " + ip.ToString() + " in block " + block.ToString() + " of " + function, LogLevel.ERROR);
+			unpatch(function);
+			return -1;
+		}
+		SQFCode code = blocks[block];
+		if(code.Op(ip) == ESQFOpCode.TRAP)
+			return code.Arg(ip); // already set
+
+		SQFBreakpoint breakpoint = new SQFBreakpoint();
+		breakpoint.m_Id = m_Breakpoints.Count();
+		breakpoint.m_Function = function;
+		breakpoint.m_Block = block;
+		breakpoint.m_IP = ip;
+		breakpoint.m_Code = code;
+		breakpoint.m_Op = code.Op(ip);
+		breakpoint.m_Arg = code.Arg(ip);
+		m_Breakpoints.Insert(breakpoint);
+		code.Patch(ip, ESQFOpCode.TRAP, breakpoint.m_Id);
+		return breakpoint.m_Id;
+	}
+	bool RemoveBreakpoint(int id)
+	{
+		SQFBreakpoint breakpoint = GetBreakpoint(id);
+		if(!breakpoint) return false;
+		// scripts holding the copy don't trap anymore either
+		breakpoint.m_Code.Patch(breakpoint.m_IP, breakpoint.m_Op, breakpoint.m_Arg);
+		m_Breakpoints[id] = null;
+		unpatch(breakpoint.m_Function);
+		return true;
+	}
+	void RemoveAll()
+	{
+		for(int id = 0; id < m_Breakpoints.Count(); id++)
+			RemoveBreakpoint(id);
+	}
+	SQFBreakpoint GetBreakpoint(int id)
+	{
+		if(id < 0 || id >= m_Breakpoints.Count()) return null;
+		return m_Breakpoints[id];
+	}
+	// the function was replaced, e.g. by SQFFunctionLibrary hot reloading it. its breakpoints move to the new code
+	void Refresh(string name)
+	{
+		string function = name;
+		function.ToLower();
+		if(m_Patched.Contains(function)) patch(function);
+	}
+	ScriptInvoker GetOnBreak()
+	{
+		return m_OnBreak;
+	}
+
+	// --- script control ---
+
+	// pause a scheduled script before its next instruction
+	void Pause(SQFScript script)
+	{
+		if(!script.IsScheduled())
+		{
+			Print("called scripts can't be paused: " + script.Name(), LogLevel.WARNING);
+			return;
+		}
+		script.Pause();
+	}
+	void Continue(SQFScript script)
+	{
+		script.SetStepping(-1);
+		script.Resume();
+	}
+	// run `instructions` more instructions, then pause again
+	void Step(SQFScript script, int instructions = 1)
+	{
+		script.SetStepping(instructions);
+		script.Resume();
+	}
+
+	// call stack of a script, innermost frame first: "<frame> @<ip> <disassembled instruction>"
+	string Backtrace(SQFScript script)
+	{
+		string text = "";
+		for(int i = script.FrameCount() - 1; i >= 0; i--)
+		{
+			SQFFrame frame = script.FrameAt(i);
+			text += "\t#" + i.ToString() + " ";
+			if(frame.IsNative())
+			{
+				text += frame.Type().ToString() + "\n";
+				continue;
+			}
+			text += "@" + frame.m_IP.ToString() + " ";
+			if(frame.m_IP < frame.m_Code.Size())
+				text += instruction(frame.m_Code, frame.m_IP);
+			else
+				text += "end";
+			if(frame.m_Locals)
+			{
+				for(int local = 0; local < frame.m_Locals.Count(); local++)
+					text += " " + frame.m_Locals.GetKey(local) + "=" + frame.m_Locals.GetElement(local).Stringify();
+			}
+			text += "\n";
+		}
+		return text;
+	}
+
+	// --- called by SQFInterpreter ---
+
+	void OnBreak(SQFScript script, SQFBreakpoint breakpoint)
+	{
+		m_OnBreak.Invoke(script, breakpoint);
+	}
+	// stepping ran out
+	void OnStep(SQFScript script)
+	{
+		m_OnBreak.Invoke(script, null);
+	}
+
+	// the patched copy of a function, made on its first breakpoint. if the function was replaced since
+	// (hot reload) the copy is stale: the current code is copied and the breakpoints move over to it
+	protected SQFValue patch(string function)
+	{
+		SQFValue stale = m_Patched.Get(function);
+		if(stale && m_Interpreter.MissionNamespace().Get(function) == stale) return stale;
+
+		SQFValue original = m_Interpreter.GetGlobal(function); // a local name isn't found, locals live in script frames
+		if(!original || original.m_Type != ESQFValueType.CODE)
+		{
+			Print("no function " + function + " to set a breakpoint in", LogLevel.ERROR);
+			return null;
+		}
+		// same pool, so constant indices stay valid
+		SQFCode code = original.m_Code;
+		SQFValue patched = SQFValue.Code(code.CopyInto(code.Constants()));
+		patched.Promote();
+		m_Originals.Set(function, original);
+		m_Patched.Set(function, patched);
+		m_Interpreter.MissionNamespace().Replace(function, patched);
+		if(stale) rebase(function, patched.m_Code);
+		return patched;
+	}
+	// move the breakpoints of `function` to the same block and instruction in `code`
+	protected void rebase(string function, SQFCode code)
+	{
+		array<SQFCode> blocks = new array<SQFCode>();
+		code.Flatten(blocks);
+		for(int id = 0; id < m_Breakpoints.Count(); id++)
+		{
+			SQFBreakpoint breakpoint = m_Breakpoints[id];
+			if(!breakpoint || breakpoint.m_Function != function) continue;
+			// scripts still running the old copy don't trap anymore
+			if(breakpoint.m_Code)
+				breakpoint.m_Code.Patch(breakpoint.m_IP, breakpoint.m_Op, breakpoint.m_Arg);
+			if(breakpoint.m_Block >= blocks.Count() || breakpoint.m_IP >= blocks[breakpoint.m_Block].Size())
+			{
+				Print("breakpoint " + id.ToString() + " is gone from the new version of " + function, LogLevel.WARNING);
+				m_Breakpoints[id] = null;
+				continue;
+			}
+			SQFCode block = blocks[breakpoint.m_Block];
+			breakpoint.m_Code = block;
+			breakpoint.m_Op = block.Op(breakpoint.m_IP);
+			breakpoint.m_Arg = block.Arg(breakpoint.m_IP);
+			block.Patch(breakpoint.m_IP, ESQFOpCode.TRAP, id);
+		}
+	}
+	// put the original code back once a function has no breakpoints left
+	protected void unpatch(string function)
+	{
+		foreach(SQFBreakpoint breakpoint : m_Breakpoints)
+		{
+			if(breakpoint && breakpoint.m_Function == function) return;
+		}
+		SQFValue original = m_Originals.Get(function);
+		if(!original) return;
+		// code installed after patching without a Refresh() stays in place
+		if(m_Interpreter.MissionNamespace().Get(function) == m_Patched.Get(function))
+			m_Interpreter.MissionNamespace().Replace(function, original);
+		m_Originals.Remove(function);
+		m_Patched.Remove(function);
+	}
+
+	protected string instruction(SQFCode code, int ip)
+	{
+		ESQFOpCode op = code.Op(ip);
+		int arg = code.Arg(ip);
+		if(op == ESQFOpCode.TRAP)
+		{
+			SQFBreakpoint breakpoint = GetBreakpoint(arg);
+			if(breakpoint)
+			{
+				op = breakpoint.m_Op;
+				arg = breakpoint.m_Arg;
+			}
+		}
+		string text = typename.EnumToString(ESQFOpCode, op) + " " + arg.ToString();
+		if(SQFCode.UsesConstant(op))
+			text += " (" + code.Constant(arg).Stringify() + ")";
+		return text;
+	}
+}
@@ -0,0 +1,164 @@
+
+
+// always-on ring buffer of what the interpreter ran, for working out after the fact which
+// scripts burned a slow frame. an entry is 5 ints: script id, id of the running block (SQFCode.Id()),
+// instruction offset in it, command id (or an ENTRY_ marker) and the frame timestamp. recording
+// one is 5 stores. superinstructions record the command they replace.
+// the buffer is written to a file on demand, after a runtime error or after a slow frame.
+class SQFFlightRecorder {
+	static const int ENTRY_SWITCH = -1; // interpreter switched to the script
+	static const int ENTRY_ERROR = -2; // runtime error in the script
+	protected static const int ENTRY_INTS = 5;
+
+	protected SQFCommands m_Commands; // for command names in dumps
+	protected ref array<int> m_Entries;
+	protected ref array<string> m_Names; // script name, only set on switch entries
+	protected int m_Capacity;
+	protected int m_Next;
+	protected bool m_Wrapped;
+
+	protected int m_FrameTime; // System.GetTickCount() when the frame began
+	protected int m_FrameThreshold = 100; // milliseconds, 0 disables dumps on slow frames
+	protected bool m_DumpOnError = true;
+	protected int m_DumpCooldown = 10000; // milliseconds between automatic dumps
+	protected int m_LastDump = -1;
+	protected string m_Path = "$profile:sqfvm_flight_recorder.log";
+
+	void SQFFlightRecorder(SQFCommands commands, int capacity = 8192)
+	{
+		m_Commands = commands;
+		SetCapacity(capacity);
+	}
+
+	// entries kept, at least 1. clears the buffer
+	void SetCapacity(int entries)
+	{
+		if(entries < 1) entries = 1;
+		m_Capacity = entries;
+		m_Entries = new array<int>();
+		m_Entries.Resize(entries * ENTRY_INTS);
+		m_Names = new array<string>();
+		m_Names.Resize(entries);
+		m_Next = 0;
+		m_Wrapped = false;
+	}
+	void SetFrameThreshold(int milliseconds)
+	{
+		m_FrameThreshold = milliseconds;
+	}
+	void SetDumpOnError(bool dump)
+	{
+		m_DumpOnError = dump;
+	}
+	void SetPath(string path)
+	{
+		m_Path = path;
+	}
+
+	void Record(int script, int code, int offset, int command)
+	{
+		int slot = m_Next * ENTRY_INTS;
+		m_Entries[slot] = script;
+		m_Entries[slot + 1] = code;
+		m_Entries[slot + 2] = offset;
+		m_Entries[slot + 3] = command;
+		m_Entries[slot + 4] = m_FrameTime;
+		m_Next++;
+		if(m_Next == m_Capacity)
+		{
+			m_Next = 0;
+			m_Wrapped = true;
+		}
+	}
+	void RecordSwitch(SQFScript script)
+	{
+		m_Names[m_Next] = script.Name();
+		Record(script.Id(), -1, -1, ENTRY_SWITCH);
+	}
+	void RecordError(SQFScript script, int code, int offset)
+	{
+		Record(script.Id(), code, offset, ENTRY_ERROR);
+		if(m_DumpOnError) autoDump("runtime error in " + script.Name() + " #" + script.Id().ToString());
+	}
+
+	// called by SQFVM around the script work of every frame
+	void BeginFrame()
+	{
+		m_FrameTime = System.GetTickCount();
+	}
+	void EndFrame()
+	{
+		if(m_FrameThreshold <= 0) return;
+		int elapsed = System.GetTickCount() - m_FrameTime;
+		if(elapsed > m_FrameThreshold)
+			autoDump("script frame took " + elapsed.ToString() + "ms");
+	}
+
+	int Count()
+	{
+		if(m_Wrapped) return m_Capacity;
+		return m_Next;
+	}
+
+	// oldest entry first, one per line: "<frame time> <script name>#<id> @<block id>:<offset> <command>"
+	string Format()
+	{
+		// names of the scripts still in the buffer
+		map<int, string> names = new map<int, string>();
+		int count = Count();
+		int oldest = 0;
+		if(m_Wrapped) oldest = m_Next;
+		for(int i = 0; i < count; i++)
+		{
+			int index = (oldest + i) % m_Capacity;
+			if(m_Entries[index * ENTRY_INTS + 3] == ENTRY_SWITCH)
+				names.Set(m_Entries[index * ENTRY_INTS], m_Names[index]);
+		}
+
+		string text = "";
+		for(int j = 0; j < count; j++)
+		{
+			int entry = (oldest + j) % m_Capacity;
+			int slot = entry * ENTRY_INTS;
+			int script = m_Entries[slot];
+			string name = "?";
+			if(names.Contains(script)) name = names.Get(script);
+
+			int command = m_Entries[slot + 3];
+			string what = "error";
+			if(command == ENTRY_SWITCH)
+				what = "run";
+			else if(command != ENTRY_ERROR)
+				what = m_Commands.Name(command);
+			text += m_Entries[slot + 4].ToString() + " " + name + "#" + script.ToString() + " @" + m_Entries[slot + 1].ToString() + ":" + m_Entries[slot + 2].ToString() + " " + what + "\n";
+		}
+		return text;
+	}
+
+	// write the buffer to `path`, the configured path by default
+	bool Dump(string reason = "on demand", string path = "")
+	{
+		if(path == "") path = m_Path;
+		FileHandle file = FileIO.OpenFile(path, FileMode.WRITE);
+		if(!file)
+		{
+			Print("failed to open flight recorder dump " + path, LogLevel.ERROR);
+			return false;
+		}
+		file.WriteLine("SQF flight recorder: " + reason + ", " + Count().ToString() + " entries");
+		file.WriteLine(Format());
+		file.Close();
+		Print("SQF flight recorder dumped to " + path + ": " + reason, LogLevel.WARNING);
+		return true;
+	}
+
+	// dumps triggered by the interpreter, at most one per cooldown so a script failing every frame
+	// doesn't turn into a file write every frame
+	protected void autoDump(string reason)
+	{
+		int now = System.GetTickCount();
+		if(m_LastDump >= 0 && now - m_LastDump < m_DumpCooldown) return;
+		m_LastDump = now;
+		Dump(reason);
+	}
+}
@@ -0,0 +1,308 @@
+
+
+// a scope on the script call stack. executes bytecode from m_Code
+class SQFFrame {
+	ref SQFCode m_Code;
+	int m_IP; // next instruction
+	int m_StackBase; // operand stack size when the frame was entered
+	ref map<string, ref SQFValue> m_Locals; // created on first private
+
+	void SQFFrame(SQFCode code = null, int stackBase = 0)
+	{
+		m_Code = code;
+		m_StackBase = stackBase;
+	}
+
+	// native frames drive control structures (loops, waitUntil) instead of running bytecode
+	bool IsNative()
+	{
+		return false;
+	}
+	// loops are left together with their body when `exitWith` fires
+	bool IsLoop()
+	{
+		return false;
+	}
+	// a child frame finished with `result`
+	void OnReturn(SQFScript script, SQFValue result)
+	{
+		script.Push(result);
+	}
+	// native frame is on top of the call stack. push a child or return
+	void Continue(SQFInterpreter vm, SQFScript script) {}
+
+	bool FindLocal(string name, out SQFValue value)
+	{
+		if(!m_Locals) return false;
+		return m_Locals.Find(name, value);
+	}
+	void SetLocal(string name, SQFValue value)
+	{
+		if(!m_Locals)
+			m_Locals = new map<string, ref SQFValue>();
+		m_Locals.Set(name, value);
+	}
+}
+
+class SQFNativeFrame : SQFFrame {
+	protected int m_Phase;
+	protected ref SQFValue m_ChildResult;
+
+	override bool IsNative()
+	{
+		return true;
+	}
+	override void OnReturn(SQFScript script, SQFValue result)
+	{
+		m_ChildResult = result;
+	}
+}
+
+// while {condition} do {body}
+class SQFWhileFrame : SQFNativeFrame {
+	protected ref SQFCode m_Condition;
+	protected ref SQFCode m_Body;
+	protected ref SQFValue m_Last;
+
+	void SQFWhileFrame(SQFCode condition, SQFCode body)
+	{
+		m_Condition = condition;
+		m_Body = body;
+		m_Last = SQFValue.Nil();
+	}
+	override bool IsLoop()
+	{
+		return true;
+	}
+	override void Continue(SQFInterpreter vm, SQFScript script)
+	{
+		switch(m_Phase)
+		{
+			case 0: // evaluate condition
+				m_Phase = 1;
+				script.PushFrame(m_Condition);
+				break;
+			case 1: // condition evaluated
+				if(m_ChildResult.m_Type != ESQFValueType.BOOL)
+				{
+					vm.RuntimeError(script, "while condition returned " + m_ChildResult.TypeName() + ", expected BOOL");
+					return;
+				}
+				if(!m_ChildResult.m_Bool)
+				{
+					vm.Return(script, m_Last);
+					return;
+				}
+				m_Phase = 2;
+				script.PushFrame(m_Body);
+				break;
+			case 2: // body finished
+				m_Last = m_ChildResult;
+				m_Phase = 0;
+				break;
+		}
+	}
+}
+
+// for "_i" from 0 to 10 step 1 do {body}
+class SQFForFrame : SQFNativeFrame {
+	protected string m_Variable;
+	protected float m_Current;
+	protected float m_To;
+	protected float m_Step;
+	protected ref SQFCode m_Body;
+	protected ref SQFValue m_Last;
+
+	void SQFForFrame(string variable, float from, float to, float step, SQFCode body)
+	{
+		m_Variable = variable;
+		m_Current = from;
+		m_To = to;
+		m_Step = step;
+		m_Body = body;
+		m_Last = SQFValue.Nil();
+	}
+	override bool IsLoop()
+	{
+		return true;
+	}
+	override void Continue(SQFInterpreter vm, SQFScript script)
+	{
+		if(m_Phase == 1) // body finished
+		{
+			m_Last = m_ChildResult;
+			m_Current += m_Step;
+		}
+		bool done = m_Current > m_To;
+		if(m_Step < 0)
+			done = m_Current < m_To;
+		if(done)
+		{
+			vm.Return(script, m_Last);
+			return;
+		}
+		m_Phase = 1;
+		SQFFrame body = script.PushFrame(m_Body);
+		body.SetLocal(m_Variable, SQFValue.Scalar(m_Current));
+	}
+}
+
+// {body} forEach array
+class SQFForEachFrame : SQFNativeFrame {
+	protected ref array<ref SQFValue> m_Array;
+	protected int m_Index;
+	protected ref SQFCode m_Body;
+	protected ref SQFValue m_Last;
+
+	void SQFForEachFrame(SQFCode body, array<ref SQFValue> values)
+	{
+		m_Body = body;
+		m_Array = values;
+		m_Last = SQFValue.Nil();
+	}
+	override bool IsLoop()
+	{
+		return true;
+	}
+	override void Continue(SQFInterpreter vm, SQFScript script)
+	{
+		if(m_Phase == 1) // body finished
+		{
+			m_Last = m_ChildResult;
+			m_Index++;
+		}
+		// array may be modified by the body, so check the live count
+		if(m_Index >= m_Array.Count())
+		{
+			vm.Return(script, m_Last);
+			return;
+		}
+		m_Phase = 1;
+		SQFFrame body = script.PushFrame(m_Body);
+		body.SetLocal("_x", m_Array[m_Index]);
+		body.SetLocal("_foreachindex", SQFValue.Scalar(m_Index));
+	}
+}
+
+// {condition} count array
+class SQFCountFrame : SQFNativeFrame {
+	protected ref array<ref SQFValue> m_Array;
+	protected int m_Index;
+	protected int m_Count;
+	protected ref SQFCode m_Condition;
+
+	void SQFCountFrame(SQFCode condition, array<ref SQFValue> values)
+	{
+		m_Condition = condition;
+		m_Array = values;
+	}
+	override bool IsLoop()
+	{
+		return true;
+	}
+	override void Continue(SQFInterpreter vm, SQFScript script)
+	{
+		if(m_Phase == 1) // condition evaluated
+		{
+			if(m_ChildResult.IsTrue()) m_Count++;
+			m_Index++;
+		}
+		if(m_Index >= m_Array.Count())
+		{
+			vm.Return(script, SQFValue.Scalar(m_Count));
+			return;
+		}
+		m_Phase = 1;
+		SQFFrame condition = script.PushFrame(m_Condition);
+		condition.SetLocal("_x", m_Array[m_Index]);
+	}
+}
+
+// waitUntil {condition}. yields the script until the condition is true
+class SQFWaitUntilFrame : SQFNativeFrame {
+	protected ref SQFCode m_Condition;
+
+	void SQFWaitUntilFrame(SQFCode condition)
+	{
+		m_Condition = condition;
+	}
+	override void Continue(SQFInterpreter vm, SQFScript script)
+	{
+		if(m_Phase == 1) // condition evaluated
+		{
+			if(m_ChildResult.IsTrue())
+			{
+				vm.Return(script, SQFValue.Nil());
+				return;
+			}
+			script.Yield(); // try again next frame
+		}
+		m_Phase = 1;
+		script.PushFrame(m_Condition);
+	}
+}
+
+// if (condition) exitWith {code}. runs code then leaves the enclosing scope
+class SQFExitWithFrame : SQFNativeFrame {
+	protected ref SQFCode m_Code;
+
+	void SQFExitWithFrame(SQFCode code)
+	{
+		m_Code = code;
+	}
+	override void Continue(SQFInterpreter vm, SQFScript script)
+	{
+		if(m_Phase == 0)
+		{
+			m_Phase = 1;
+			script.PushFrame(m_Code);
+			return;
+		}
+		// pop ourself and the scope we exit from
+		SQFValue result = m_ChildResult;
+		script.PopFrame();
+		script.PopFrame();
+		// exiting a loop body exits the loop too
+		SQFFrame parent = script.Top();
+		if(parent && parent.IsLoop())
+			script.PopFrame();
+		vm.Deliver(script, result);
+	}
+}
+
+// try {code} catch {handler}. a `throw` inside code unwinds to here and runs handler with `_exception`
+class SQFTryFrame : SQFNativeFrame {
+	protected ref SQFCode m_Try;
+	protected ref SQFCode m_Catch;
+	protected bool m_Grace; // catching the heap limit, see SQFArena.BeginGrace()
+
+	void SQFTryFrame(SQFCode tryCode, SQFCode catchCode)
+	{
+		m_Try = tryCode;
+		m_Catch = catchCode;
+	}
+	// true while the try code runs. throws from the handler go further up
+	bool IsGuarding()
+	{
+		return m_Phase == 1;
+	}
+	// the frames above were unwound by Throw()
+	void Catch(SQFScript script, SQFValue exception)
+	{
+		m_Phase = 2;
+		m_Grace = script.Arena().ClaimGrace(); // before the handler frame is charged
+		SQFFrame handler = script.PushFrame(m_Catch);
+		handler.SetLocal("_exception", exception);
+	}
+	override void Continue(SQFInterpreter vm, SQFScript script)
+	{
+		if(m_Phase == 0)
+		{
+			m_Phase = 1;
+			script.PushFrame(m_Try);
+			return;
+		}
+		if(m_Grace) script.Arena().EndGrace();
+		vm.Return(script, m_ChildResult); // code or handler finished
+	}
+}
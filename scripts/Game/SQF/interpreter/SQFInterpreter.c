@@ -1,6 +1,658 @@
+// why Run() stopped
+enum ESQFRunResult {
+	RUNNING,
+	DONE,
+	SUSPENDED,	// sleep, waitUntil or yield
+	BUDGET,		// instruction budget spent
+	HEAP,		// arena went over the heap limit
+};
 
-
+// runs SQFCode. scripts are either called (unscheduled, run to completion) or
+// spawned (scheduled, given a slice of instructions every frame)
 class SQFInterpreter {
+	protected ref SQFCommands m_Commands;
+	protected ref SQFParser m_Parser;
+	protected ref SQFOptimizer m_Optimizer;
+	protected bool m_Optimize = true;
+	protected ref SQFCompileCache m_CompileCache;
+	protected ref SQFNamespace m_MissionNamespace;
+	protected ref array<ref SQFScript> m_Scheduled;
+	protected ref map<string, int> m_PeakMemory; // script name -> highest arena high-water mark seen
+	protected ref SQFScriptLimits m_Limits;
+	protected ref SQFFlightRecorder m_Recorder;
+	protected ref SQFDebugger m_Debugger;
+	protected ref map<string, ref array<int>> m_LimitHits; // script name -> hits per ESQFLimit
+	protected SQFFunctionLibrary m_Functions; // owned by SQFVM
+	protected SQFEventHandlers m_EventHandlers; // owned by SQFVM
+
+	void SQFInterpreter()
+	{
+		m_Commands = new SQFCommands();
+		m_Parser = new SQFParser(m_Commands);
+		m_Optimizer = new SQFOptimizer();
+		m_CompileCache = new SQFCompileCache();
+		m_MissionNamespace = new SQFNamespace("missionNamespace");
+		m_Scheduled = new array<ref SQFScript>();
+		m_PeakMemory = new map<string, int>();
+		m_Limits = new SQFScriptLimits();
+		m_Recorder = new SQFFlightRecorder(m_Commands);
+		m_Debugger = new SQFDebugger(this);
+		m_LimitHits = new map<string, ref array<int>>();
+	}
+
+	SQFCommands Commands()
+	{
+		return m_Commands;
+	}
+	SQFNamespace MissionNamespace()
+	{
+		return m_MissionNamespace;
+	}
+	// functions not yet compiled are resolved through the library on first use
+	void SetFunctionLibrary(SQFFunctionLibrary functions)
+	{
+		m_Functions = functions;
+	}
+
+	// quotas. instruction quotas and actions are read live, every slice and call uses the current
+	// values. the heap limit is copied into a script's arena when it starts
+	SQFScriptLimits GetLimits()
+	{
+		return m_Limits;
+	}
+
+	// recent commands of every script, dumped after errors and slow frames
+	SQFFlightRecorder GetFlightRecorder()
+	{
+		return m_Recorder;
+	}
+
+	// breakpoints and stepping
+	SQFDebugger GetDebugger()
+	{
+		return m_Debugger;
+	}
+
+	// target of `addMissionEventHandler`
+	void SetEventHandlers(SQFEventHandlers eventHandlers)
+	{
+		m_EventHandlers = eventHandlers;
+	}
+	SQFEventHandlers EventHandlers()
+	{
+		return m_EventHandlers;
+	}
+
+	// fuse common idioms into superinstructions when compiling, on by default
+	void SetOptimize(bool optimize)
+	{
+		m_Optimize = optimize;
+	}
+
+	// compile SQF text. returns null on syntax errors
+	SQFCode Compile(string source, bool isFinal = false)
+	{
+		SQFCode code = m_Parser.Parse(source);
+		if(!code) return null;
+		if(m_Optimize)
+			m_Optimizer.Optimize(code);
+		if(isFinal)
+			code.SetFinal(true);
+		return code;
+	}
+
+	// link an edited document into runnable code. null if it has errors, see SQFDocument.Diagnostics()
+	SQFCode CompileDocument(SQFDocument document, bool isFinal = false)
+	{
+		SQFCode code = document.Link();
+		if(!code) return null;
+		if(m_Optimize)
+			m_Optimizer.Optimize(code);
+		if(isFinal)
+			code.SetFinal(true);
+		return code;
+	}
+
+	// the `compile` command. the same string compiles once and every caller shares the value
+	SQFValue CompileCached(string source, bool isFinal = false)
+	{
+		SQFValue value = m_CompileCache.Find(source, isFinal);
+		if(value) return value;
+		SQFCode code = Compile(source, isFinal);
+		if(!code) return null;
+		return m_CompileCache.Insert(source, isFinal, code);
+	}
+	SQFCompileCache GetCompileCache()
+	{
+		return m_CompileCache;
+	}
+
+	// run code to completion in an unscheduled environment
+	SQFValue Call(SQFCode code, SQFValue args = null, string name = "call")
+	{
+		SQFScript script = newScript(code, args, name, false);
+		return runUnscheduled(script);
+	}
+	// Call() in a script the caller keeps. the script is restarted and its pooled frames reused,
+	// so calling the same handler over and over sets nothing up. see SQFEventHandlers
+	SQFValue Invoke(SQFScript script, SQFCode code, SQFValue args = null)
+	{
+		script.Restart();
+		SQFFrame frame = script.PushFrame(code);
+		if(args) frame.SetLocal("_this", args);
+		return runUnscheduled(script);
+	}
+	// an unscheduled script for Invoke()
+	SQFScript CreatePersistentScript(string name)
+	{
+		SQFScript script = new SQFScript(name, false);
+		script.SetPersistent(true);
+		script.Arena().SetLimit(m_Limits.m_MaxHeapBytes);
+		return script;
+	}
+
+	// start a scheduled script. it runs from the next Simulate()
+	SQFScript Spawn(SQFCode code, SQFValue args = null, string name = "spawn")
+	{
+		SQFScript script = newScript(code, args, name, true);
+		m_Scheduled.Insert(script);
+		return script;
+	}
+
+	// give every scheduled script its slice. called once per frame
+	void Simulate()
+	{
+		int now = System.GetTickCount();
+		for(int i = 0; i < m_Scheduled.Count(); i++)
+		{
+			SQFScript script = m_Scheduled[i];
+			if(!script.TryWake(now)) continue;
+			ESQFRunResult result = Run(script, m_Limits.m_SliceInstructions);
+			if(result == ESQFRunResult.BUDGET)
+				limitReached(script, ESQFLimit.SLICE, m_Limits.m_SliceAction);
+			else if(result == ESQFRunResult.HEAP)
+				limitReached(script, ESQFLimit.HEAP, m_Limits.m_HeapAction);
+		}
+		for(int j = m_Scheduled.Count() - 1; j >= 0; j--)
+		{
+			if(!m_Scheduled[j].IsDone()) continue;
+			recordMemory(m_Scheduled[j]);
+			m_Scheduled.RemoveOrdered(j);
+		}
+	}
+	int ScheduledCount()
+	{
+		return m_Scheduled.Count();
+	}
+
+	// --- memory ---
+
+	// highest memory high-water mark of any finished script called `name`
+	int GetPeakMemory(string name)
+	{
+		return m_PeakMemory.Get(name);
+	}
+	// running scripts with their current and peak bytes, then peaks of finished scripts
+	string MemoryReport()
+	{
+		string report = "running:\n";
+		foreach(SQFScript script : m_Scheduled)
+		{
+			SQFArena arena = script.Arena();
+			report += "\t" + script.Name() + " #" + script.Id().ToString() + ": " + arena.BytesInUse().ToString() + " bytes, peak " + arena.HighWater().ToString() + "\n";
+		}
+		report += "finished:\n";
+		for(int i = 0; i < m_PeakMemory.Count(); i++)
+		{
+			report += "\t" + m_PeakMemory.GetKey(i) + ": peak " + m_PeakMemory.GetElement(i).ToString() + "\n";
+		}
+		return report;
+	}
+	protected void recordMemory(SQFScript script)
+	{
+		int peak = script.Arena().HighWater();
+		if(peak > m_PeakMemory.Get(script.Name()))
+			m_PeakMemory.Set(script.Name(), peak);
+	}
+
+	// --- limits ---
+
+	// times scripts called `name` hit `limit`, including slice preemption
+	int GetLimitHits(string name, ESQFLimit limit)
+	{
+		array<int> hits = m_LimitHits.Get(name);
+		if(!hits) return 0;
+		return hits[limit];
+	}
+	// every script that hit a limit, with hits per limit
+	string LimitReport()
+	{
+		string report = "";
+		for(int i = 0; i < m_LimitHits.Count(); i++)
+		{
+			array<int> hits = m_LimitHits.GetElement(i);
+			report += "\t" + m_LimitHits.GetKey(i) + ":";
+			for(int limit = ESQFLimit.SLICE; limit <= ESQFLimit.HEAP; limit++)
+				report += " " + typename.EnumToString(ESQFLimit, limit) + " " + hits[limit].ToString();
+			report += "\n";
+		}
+		return report;
+	}
+
+	protected SQFValue runUnscheduled(SQFScript script)
+	{
+		int hits = 0;
+		ESQFRunResult result = Run(script, m_Limits.m_UnscheduledInstructions);
+		while(!script.IsDone())
+		{
+			if(result == ESQFRunResult.SUSPENDED)
+			{
+				RuntimeError(script, "unscheduled script suspended");
+				break;
+			}
+			ESQFLimit limit = ESQFLimit.UNSCHEDULED;
+			if(result == ESQFRunResult.HEAP) limit = ESQFLimit.HEAP;
+			// called scripts can't suspend, and only get one chance to catch a limit
+			ESQFLimitAction action = m_Limits.Action(limit);
+			if(limit == ESQFLimit.HEAP && script.Arena().ConsumeRecovered()) hits = 0; // freed what the last hit was about
+			hits++;
+			if(action == ESQFLimitAction.SUSPEND || hits > 1) action = ESQFLimitAction.TERMINATE;
+			limitReached(script, limit, action);
+			if(script.IsDone()) break;
+			result = Run(script, m_Limits.m_UnscheduledInstructions);
+		}
+		recordMemory(script);
+		return script.Result();
+	}
+	protected SQFScript newScript(SQFCode code, SQFValue args, string name, bool scheduled)
+	{
+		SQFScript script = new SQFScript(name, scheduled);
+		script.Arena().SetLimit(m_Limits.m_MaxHeapBytes);
+		SQFFrame frame = script.PushFrame(code);
+		if(args) frame.SetLocal("_this", args);
+		return script;
+	}
+
+	protected void limitReached(SQFScript script, ESQFLimit limit, ESQFLimitAction action)
+	{
+		script.CountLimitHit(limit);
+		array<int> hits = m_LimitHits.Get(script.Name());
+		if(!hits)
+		{
+			hits = new array<int>();
+			for(int i = ESQFLimit.SLICE; i <= ESQFLimit.HEAP; i++)
+				hits.Insert(0);
+			m_LimitHits.Insert(script.Name(), hits);
+		}
+		hits[limit] = hits[limit] + 1;
+
+		// running out of slice is how scheduled scripts share the frame, not worth a warning
+		if(limit == ESQFLimit.SLICE && action == ESQFLimitAction.SUSPEND) return;
+
+		string message = typename.EnumToString(ESQFLimit, limit) + " limit of " + m_Limits.Quota(limit).ToString() + " exceeded";
+		switch(action)
+		{
+			case ESQFLimitAction.SUSPEND:
+				Print("SQF script " + script.Name() + " #" + script.Id().ToString() + " suspended: " + message, LogLevel.WARNING);
+				return;
+			case ESQFLimitAction.THROW:
+				Print("SQF script " + script.Name() + " #" + script.Id().ToString() + " throwing: " + message, LogLevel.WARNING);
+				if(limit == ESQFLimit.HEAP) script.Arena().BeginGrace();
+				Throw(script, SQFValue.Text(message));
+				return;
+		}
+		RuntimeError(script, message);
+	}
+
+	// --- variables ---
+
+	static bool IsLocal(string name)
+	{
+		return name.Length() > 0 && name.Get(0) == "_";
+	}
+	// returns null if the variable is undefined
+	SQFValue GetVariable(SQFScript script, string name)
+	{
+		if(IsLocal(name)) return script.GetLocal(name);
+		return GetGlobal(name);
+	}
+	// a missionNamespace variable, compiling a pending library function on first use
+	SQFValue GetGlobal(string name)
+	{
+		SQFValue value = m_MissionNamespace.Get(name);
+		if(!value && m_Functions)
+			value = m_Functions.Resolve(name);
+		return value;
+	}
+	void SetVariable(SQFScript script, string name, SQFValue value)
+	{
+		if(IsLocal(name))
+		{
+			script.SetLocal(name, value);
+			return;
+		}
+		// a library function isn't in the namespace until compiled, compile it so Set() refuses the write
+		if(m_Functions && m_Functions.IsPending(name)) m_Functions.Resolve(name);
+		// globals outlive the script, so they stop counting against its arena
+		value.Promote();
+		m_MissionNamespace.Set(name, value);
+	}
+
+	// --- frames ---
+
+	// pop the top frame and hand `result` to the frame below
+	void Return(SQFScript script, SQFValue result)
+	{
+		script.PopFrame();
+		Deliver(script, result);
+	}
+	// hand `result` to the top frame, or finish the script if nothing is left
+	void Deliver(SQFScript script, SQFValue result)
+	{
+		SQFFrame parent = script.Top();
+		if(!parent)
+		{
+			script.Finish(result);
+			return;
+		}
+		parent.OnReturn(script, result);
+	}
+
+	// `throw value`: unwind to the closest `try` block still running its code. uncaught throws end the script
+	void Throw(SQFScript script, SQFValue exception)
+	{
+		for(int i = script.FrameCount() - 1; i >= 0; i--)
+		{
+			SQFTryFrame guard = SQFTryFrame.Cast(script.FrameAt(i));
+			if(!guard || !guard.IsGuarding()) continue;
+			while(script.FrameCount() > i + 1)
+				script.PopFrame();
+			guard.Catch(script, exception);
+			return;
+		}
+		RuntimeError(script, "uncaught exception: " + exception.Format());
+	}
+
+	void RuntimeError(SQFScript script, string message)
+	{
+		Print("SQF error in " + script.Name() + " #" + script.Id().ToString() + ": " + message, LogLevel.ERROR);
+		int block = -1;
+		int offset = -1;
+		SQFFrame frame = script.Top();
+		if(frame && !frame.IsNative())
+		{
+			block = frame.m_Code.Id();
+			offset = frame.m_IP - 1;
+		}
+		m_Recorder.RecordError(script, block, offset);
+		script.Terminate();
+	}
+
+	// execute up to `budget` instructions
+	ESQFRunResult Run(SQFScript script, int budget)
+	{
+		// heap created while running is charged to this script
+		SQFArena previous = SQFArena.s_Current;
+		SQFArena.s_Current = script.Arena();
+		m_Recorder.RecordSwitch(script);
+		ESQFRunResult result = dispatch(script, budget);
+		SQFArena.s_Current = previous;
+		return result;
+	}
+
+	protected ESQFRunResult dispatch(SQFScript script, int budget)
+	{
+		while(true)
+		{
+			// one flag covers sleep, yield, termination and quotas
+			if(script.IsInterrupted())
+			{
+				ESQFRunResult reason = interrupted(script);
+				if(reason != ESQFRunResult.RUNNING) return reason;
+			}
+			if(budget <= 0) return ESQFRunResult.BUDGET;
+
+			SQFFrame frame = script.Top();
+			if(!frame)
+			{
+				script.Finish(SQFValue.Nil());
+				return ESQFRunResult.DONE;
+			}
+			budget--;
+
+			if(frame.IsNative())
+			{
+				frame.Continue(this, script);
+				continue;
+			}
+			SQFCode code = frame.m_Code;
+			if(frame.m_IP >= code.Size())
+			{
+				// the last value left on the stack is the result of the code
+				SQFValue result = SQFValue.Nil();
+				if(script.StackSize() > frame.m_StackBase)
+					result = script.StackAt(script.StackSize() - 1);
+				Return(script, result);
+				continue;
+			}
+			int ip = frame.m_IP;
+			frame.m_IP++;
+			execute(script, frame, code.Op(ip), code.Arg(ip));
+		}
+		return ESQFRunResult.DONE;
+	}
+
+	protected ESQFRunResult interrupted(SQFScript script)
+	{
+		if(script.IsDone()) return ESQFRunResult.DONE;
+		// a pending yield keeps the flag set and is picked up by the next Run()
+		if(script.Arena().ConsumeExceeded()) return ESQFRunResult.HEAP;
+		if(script.State() != ESQFScriptState.RUNNING) return ESQFRunResult.SUSPENDED; // sleeping or paused
+		script.ClearInterrupt();
+		// the breakpoint it paused on was removed meanwhile, don't skip the next one instead
+		if(script.IsSkippingTrap() && !atTrap(script)) script.ConsumeSkipTrap();
+		if(script.IsStepping())
+		{
+			script.Interrupt(); // look again before the next instruction
+			if(!script.TakeStep())
+			{
+				script.Pause();
+				m_Debugger.OnStep(script);
+				return ESQFRunResult.SUSPENDED;
+			}
+		}
+		if(script.ConsumeYield()) return ESQFRunResult.SUSPENDED;
+		return ESQFRunResult.RUNNING;
+	}
+	protected bool atTrap(SQFScript script)
+	{
+		SQFFrame frame = script.Top();
+		if(!frame || frame.IsNative() || frame.m_IP >= frame.m_Code.Size()) return false;
+		return frame.m_Code.Op(frame.m_IP) == ESQFOpCode.TRAP;
+	}
+
+	protected void execute(SQFScript script, SQFFrame frame, ESQFOpCode op, int arg)
+	{
+		SQFCode code = frame.m_Code;
+		switch(op)
+		{
+			case ESQFOpCode.PUSH_NUMBER:
+				script.Push(code.Constant(arg));
+				return;
+			case ESQFOpCode.PUSH_STRING:
+				script.Push(code.Constant(arg));
+				return;
+			case ESQFOpCode.PUSH_BOOL:
+				script.Push(SQFValue.Boolean(arg != 0));
+				return;
+			case ESQFOpCode.PUSH_CODE:
+				script.Push(SQFValue.Code(code.Block(arg)));
+				return;
+			case ESQFOpCode.MAKE_ARRAY:
+				int first = script.StackSize() - arg;
+				array<ref SQFValue> values = new array<ref SQFValue>();
+				for(int i = 0; i < arg; i++)
+					values.Insert(script.StackAt(first + i));
+				script.Truncate(first);
+				script.Push(SQFValue.List(values));
+				return;
+			case ESQFOpCode.GET_VAR:
+				SQFValue value = GetVariable(script, code.Name(arg));
+				if(!value) value = SQFValue.Nil();
+				script.Push(value);
+				return;
+			case ESQFOpCode.SET_VAR:
+				SetVariable(script, code.Name(arg), script.Pop());
+				return;
+			case ESQFOpCode.SET_PRIVATE:
+				script.SetPrivate(code.Name(arg), script.Pop());
+				return;
+			case ESQFOpCode.CALL_NULAR:
+				m_Recorder.Record(script.Id(), code.Id(), frame.m_IP - 1, arg);
+				m_Commands.ExecuteNular(this, script, arg);
+				return;
+			case ESQFOpCode.CALL_UNARY:
+				m_Recorder.Record(script.Id(), code.Id(), frame.m_IP - 1, arg);
+				SQFValue operand = script.Pop();
+				m_Commands.ExecuteUnary(this, script, arg, operand);
+				return;
+			case ESQFOpCode.CALL_BINARY:
+				m_Recorder.Record(script.Id(), code.Id(), frame.m_IP - 1, arg);
+				SQFValue right = script.Pop();
+				SQFValue left = script.Pop();
+				m_Commands.ExecuteBinary(this, script, arg, left, right);
+				return;
+			case ESQFOpCode.END_STATEMENT:
+				script.Truncate(frame.m_StackBase);
+				return;
+
+			// superinstructions. anything off the fast path falls back to the regular command
+			// so errors read the same as unoptimized code
+			case ESQFOpCode.INC_LOCAL:
+			case ESQFOpCode.DEC_LOCAL:
+				int arithmetic = ESQFCommand.PLUS;
+				if(op == ESQFOpCode.DEC_LOCAL) arithmetic = ESQFCommand.MINUS;
+				m_Recorder.Record(script.Id(), code.Id(), frame.m_IP - 1, arithmetic);
+				string counter = code.Name(arg);
+				SQFValue current = script.GetLocal(counter);
+				if(current && current.m_Type == ESQFValueType.SCALAR)
+				{
+					if(op == ESQFOpCode.INC_LOCAL)
+						script.SetLocal(counter, SQFValue.Scalar(current.m_Scalar + 1));
+					else
+						script.SetLocal(counter, SQFValue.Scalar(current.m_Scalar - 1));
+					return;
+				}
+				if(!current) current = SQFValue.Nil();
+				m_Commands.ExecuteBinary(this, script, arithmetic, current, SQFValue.Scalar(1));
+				if(!script.IsDone())
+					script.SetLocal(counter, script.Pop());
+				return;
+			case ESQFOpCode.PUSHBACK_LOCAL:
+				m_Recorder.Record(script.Id(), code.Id(), frame.m_IP - 1, ESQFCommand.PUSH_BACK);
+				SQFValue element = script.Pop();
+				SQFValue list = script.GetLocal(code.Name(arg));
+				if(list && list.m_Type == ESQFValueType.ARRAY)
+				{
+					list.Account(SQFArena.ELEMENT_BYTES);
+					list.Changed(element);
+					script.Push(SQFValue.Scalar(list.m_Array.Insert(element)));
+					return;
+				}
+				if(!list) list = SQFValue.Nil();
+				m_Commands.ExecuteBinary(this, script, ESQFCommand.PUSH_BACK, list, element);
+				return;
+			case ESQFOpCode.SELECT_CONST:
+				m_Recorder.Record(script.Id(), code.Id(), frame.m_IP - 1, ESQFCommand.SELECT);
+				SQFValue selectFrom = script.Pop();
+				if(selectFrom.m_Type == ESQFValueType.ARRAY)
+				{
+					script.Push(SQFCommands.Select(selectFrom.m_Array, arg));
+					return;
+				}
+				m_Commands.ExecuteBinary(this, script, ESQFCommand.SELECT, selectFrom, SQFValue.Scalar(arg));
+				return;
+			case ESQFOpCode.COUNT_LOCAL:
+				m_Recorder.Record(script.Id(), code.Id(), frame.m_IP - 1, ESQFCommand.COUNT);
+				SQFValue counted = script.GetLocal(code.Name(arg));
+				if(counted && counted.m_Type == ESQFValueType.ARRAY)
+				{
+					script.Push(SQFValue.Scalar(counted.m_Array.Count()));
+					return;
+				}
+				if(!counted) counted = SQFValue.Nil();
+				m_Commands.ExecuteUnary(this, script, ESQFCommand.COUNT, counted);
+				return;
+			case ESQFOpCode.IS_NIL_VAR:
+				m_Recorder.Record(script.Id(), code.Id(), frame.m_IP - 1, ESQFCommand.IS_NIL);
+				SQFValue checked = GetVariable(script, code.Name(arg));
+				script.Push(SQFValue.Boolean(!checked || checked.IsNil()));
+				return;
+			case ESQFOpCode.IF_THEN:
+				m_Recorder.Record(script.Id(), code.Id(), frame.m_IP - 1, ESQFCommand.IF);
+				branch(script, script.Pop(), code.Block(arg));
+				return;
+			case ESQFOpCode.IF_COMPARE_THEN:
+				int comparison = arg & 0xFF;
+				m_Recorder.Record(script.Id(), code.Id(), frame.m_IP - 1, comparison);
+				SQFValue rhs = script.Pop();
+				SQFValue lhs = script.Pop();
+				SQFValue condition;
+				if(lhs.m_Type == ESQFValueType.SCALAR && rhs.m_Type == ESQFValueType.SCALAR)
+				{
+					condition = SQFValue.Boolean(SQFCommands.Compare(comparison, lhs.m_Scalar, rhs.m_Scalar));
+				}
+				else
+				{
+					m_Commands.ExecuteBinary(this, script, comparison, lhs, rhs);
+					if(script.IsDone()) return;
+					condition = script.Pop();
+				}
+				branch(script, condition, code.Block(arg >> 8));
+				return;
+			case ESQFOpCode.TRAP:
+				trap(script, frame, arg);
+				return;
+		}
+		RuntimeError(script, "invalid instruction " + op.ToString());
+	}
+
+	// breakpoint hit. scheduled scripts pause on it, called ones can't and only report it
+	protected void trap(SQFScript script, SQFFrame frame, int id)
+	{
+		SQFBreakpoint breakpoint = m_Debugger.GetBreakpoint(id);
+		if(!breakpoint)
+		{
+			RuntimeError(script, "stale breakpoint " + id.ToString());
+			return;
+		}
+		if(!script.ConsumeSkipTrap())
+		{
+			breakpoint.m_Hits++;
+			if(script.IsScheduled())
+			{
+				frame.m_IP--; // back on the trap, which runs the original instruction once resumed
+				script.SkipTrap();
+				script.Pause();
+				m_Debugger.OnBreak(script, breakpoint);
+				return;
+			}
+			m_Debugger.OnBreak(script, breakpoint);
+		}
+		execute(script, frame, breakpoint.m_Op, breakpoint.m_Arg);
+	}
 
-	void SQFInterpreter() {} // not implemented
-}
\ No newline at end of file
+	// `if <condition> then {block}`
+	protected void branch(SQFScript script, SQFValue condition, SQFCode block)
+	{
+		if(condition.m_Type != ESQFValueType.BOOL)
+		{
+			m_Commands.ExecuteUnary(this, script, ESQFCommand.IF, condition); // raises the type error
+			return;
+		}
+		if(condition.m_Bool)
+			script.PushFrame(block);
+		else
+			script.Push(SQFValue.Nil());
+	}
+}
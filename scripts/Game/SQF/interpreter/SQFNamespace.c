@@ -0,0 +1,123 @@
+
+
+// global variable storage (missionNamespace). names are case sensitive here, callers pass them lower case
+// (the lexer lowers identifiers, commands taking a name as a string lower it).
+// variables assigned or removed since the last TakeDirty() are tracked for incremental saves (SQFSnapshotStore)
+class SQFNamespace {
+	protected string m_Name;
+	protected ref map<string, ref SQFValue> m_Variables;
+	protected ref set<string> m_Dirty;
+	protected int m_SeenChanges; // SQFValue.s_Changes at the last TakeDirty()
+
+	void SQFNamespace(string name)
+	{
+		m_Name = name;
+		m_Variables = new map<string, ref SQFValue>();
+		m_Dirty = new set<string>();
+	}
+
+	string Name()
+	{
+		return m_Name;
+	}
+
+	SQFValue Get(string name)
+	{
+		return m_Variables.Get(name);
+	}
+	bool Contains(string name)
+	{
+		return m_Variables.Contains(name);
+	}
+	// returns false if the variable holds `compileFinal` code and can't be overwritten
+	bool Set(string name, SQFValue value)
+	{
+		SQFValue existing = m_Variables.Get(name);
+		if(existing && existing.m_Type == ESQFValueType.CODE && existing.m_Code.IsFinal())
+		{
+			Print("attempt to overwrite final variable: " + name, LogLevel.WARNING);
+			return false;
+		}
+		MarkDirty(name);
+		if(!value || value.IsNil())
+		{
+			m_Variables.Remove(name);
+			return true;
+		}
+		m_Variables.Set(name, value);
+		return true;
+	}
+	// Set() that also replaces final code. only for hot reloading functions
+	void Replace(string name, SQFValue value)
+	{
+		MarkDirty(name);
+		m_Variables.Set(name, value);
+	}
+	// set a loaded value, null removes. the variable stays clean since it matches the save.
+	// returns false for variables holding `compileFinal` code, those aren't touched
+	bool Restore(string name, SQFValue value)
+	{
+		SQFValue existing = m_Variables.Get(name);
+		if(existing && existing.m_Type == ESQFValueType.CODE && existing.m_Code.IsFinal())
+			return false;
+		if(!value)
+		{
+			m_Variables.Remove(name);
+			return true;
+		}
+		m_Variables.Set(name, value);
+		return true;
+	}
+	int Count()
+	{
+		return m_Variables.Count();
+	}
+	string NameAt(int index)
+	{
+		return m_Variables.GetKey(index);
+	}
+	SQFValue ValueAt(int index)
+	{
+		return m_Variables.GetElement(index);
+	}
+	void Clear()
+	{
+		m_Variables.Clear();
+		m_Dirty.Clear();
+	}
+
+	void MarkDirty(string name)
+	{
+		m_Dirty.Insert(name);
+	}
+	bool IsDirty(string name)
+	{
+		return m_Dirty.Contains(name);
+	}
+	int DirtyCount()
+	{
+		return m_Dirty.Count();
+	}
+	// move the dirty names into `names`. arrays changed in place (`pushBack`, `set`) don't go through
+	// Set(), they are found by their change flags. that walks every global array, but only when some
+	// global array changed since the last call (SQFValue.s_Changes). an array can be shared by several
+	// globals, so every global reaching a change is collected before any flag is cleared
+	void TakeDirty(array<string> names)
+	{
+		if(m_SeenChanges != SQFValue.s_Changes)
+		{
+			m_SeenChanges = SQFValue.s_Changes;
+			int i;
+			for(i = 0; i < m_Variables.Count(); i++)
+			{
+				if(m_Variables.GetElement(i).HasChanged())
+					m_Dirty.Insert(m_Variables.GetKey(i));
+			}
+			for(i = 0; i < m_Variables.Count(); i++)
+				m_Variables.GetElement(i).ClearChanged();
+		}
+		for(int j = 0; j < m_Dirty.Count(); j++)
+			names.Insert(m_Dirty.Get(j));
+		m_Dirty.Clear();
+	}
+}
@@ -0,0 +1,336 @@
+
+
+enum ESQFScriptState {
+	RUNNING,
+	SLEEPING, // `sleep` until m_WakeTime
+	PAUSED, // stopped by SQFDebugger
+	DONE,
+};
+
+// a running SQF script instance. owns the call stack and the operand stack
+class SQFScript {
+	protected static int s_NextId = 1;
+
+	protected int m_Id;
+	protected string m_Name;
+	protected bool m_Scheduled; // spawned scripts may suspend, called ones may not
+	protected ESQFScriptState m_State;
+	protected int m_WakeTime;
+	protected bool m_Yield;
+	protected bool m_SkipTrap; // run the original instruction under the next breakpoint
+	protected int m_Steps; // instructions left before pausing, -1 when not stepping
+	protected int m_SleepLeft = -1; // milliseconds of `sleep` left when paused, -1 if it wasn't asleep
+	protected bool m_Persistent; // restarted by the interpreter instead of thrown away
+	protected bool m_Interrupted; // sleep, yield, termination or quota. checked once per instruction
+	protected ref array<int> m_LimitHits; // per ESQFLimit
+
+	protected ref array<ref SQFFrame> m_Frames;
+	protected ref array<ref SQFValue> m_Stack;
+	protected ref SQFValue m_Result;
+	protected ref SQFArena m_Arena;
+
+	void SQFScript(string name, bool scheduled)
+	{
+		m_Id = s_NextId++;
+		m_Name = name;
+		m_Scheduled = scheduled;
+		m_State = ESQFScriptState.RUNNING;
+		m_Steps = -1;
+		m_Frames = new array<ref SQFFrame>();
+		m_Stack = new array<ref SQFValue>();
+		m_Result = SQFValue.Nil();
+		m_Arena = new SQFArena(this);
+		m_LimitHits = new array<int>();
+		for(int limit = ESQFLimit.SLICE; limit <= ESQFLimit.HEAP; limit++)
+			m_LimitHits.Insert(0);
+	}
+
+	int Id()
+	{
+		return m_Id;
+	}
+	string Name()
+	{
+		return m_Name;
+	}
+	bool IsScheduled()
+	{
+		return m_Scheduled;
+	}
+	ESQFScriptState State()
+	{
+		return m_State;
+	}
+	bool IsDone()
+	{
+		return m_State == ESQFScriptState.DONE;
+	}
+	SQFValue Result()
+	{
+		return m_Result;
+	}
+	// memory owned by this script, see BytesInUse() and HighWater()
+	SQFArena Arena()
+	{
+		return m_Arena;
+	}
+	// persistent scripts keep their frame pool when they finish and can be restarted
+	void SetPersistent(bool persistent)
+	{
+		m_Persistent = persistent;
+	}
+	// times this script hit `limit`
+	int LimitHits(ESQFLimit limit)
+	{
+		return m_LimitHits[limit];
+	}
+	void CountLimitHit(ESQFLimit limit)
+	{
+		m_LimitHits[limit] = m_LimitHits[limit] + 1;
+	}
+
+	// --- call stack ---
+
+	SQFFrame Top()
+	{
+		int count = m_Frames.Count();
+		if(count == 0) return null;
+		return m_Frames[count - 1];
+	}
+	int FrameCount()
+	{
+		return m_Frames.Count();
+	}
+	SQFFrame FrameAt(int index)
+	{
+		return m_Frames[index];
+	}
+	// enter a new scope running `code`
+	SQFFrame PushFrame(SQFCode code)
+	{
+		SQFFrame frame = m_Arena.AcquireFrame(code, m_Stack.Count());
+		m_Frames.Insert(frame);
+		return frame;
+	}
+	void PushNative(SQFNativeFrame frame)
+	{
+		m_Arena.Charge(SQFArena.FRAME_BYTES);
+		frame.m_StackBase = m_Stack.Count();
+		m_Frames.Insert(frame);
+	}
+	// leave the top scope, discarding anything it left on the operand stack
+	void PopFrame()
+	{
+		int count = m_Frames.Count();
+		if(count == 0) return;
+		SQFFrame frame = m_Frames[count - 1];
+		Truncate(frame.m_StackBase);
+		m_Frames.Remove(count - 1);
+		m_Arena.ReleaseFrame(frame);
+	}
+
+	// --- operand stack ---
+
+	void Push(SQFValue value)
+	{
+		m_Stack.Insert(value);
+	}
+	SQFValue Pop()
+	{
+		int count = m_Stack.Count();
+		if(count == 0) return SQFValue.Nil();
+		SQFValue value = m_Stack[count - 1];
+		m_Stack.Remove(count - 1);
+		return value;
+	}
+	int StackSize()
+	{
+		return m_Stack.Count();
+	}
+	SQFValue StackAt(int index)
+	{
+		return m_Stack[index];
+	}
+	void Truncate(int size)
+	{
+		if(size < m_Stack.Count())
+			m_Stack.Resize(size);
+	}
+
+	// --- local variables ---
+	// SQF locals are dynamically scoped: called code sees the locals of its caller
+
+	SQFValue GetLocal(string name)
+	{
+		SQFValue value;
+		for(int i = m_Frames.Count() - 1; i >= 0; i--)
+		{
+			if(m_Frames[i].FindLocal(name, value)) return value;
+		}
+		return null;
+	}
+	// assign to the closest scope defining `name`, or create it in the current scope
+	void SetLocal(string name, SQFValue value)
+	{
+		SQFValue existing;
+		for(int i = m_Frames.Count() - 1; i >= 0; i--)
+		{
+			if(m_Frames[i].FindLocal(name, existing))
+			{
+				m_Frames[i].SetLocal(name, value);
+				return;
+			}
+		}
+		SetPrivate(name, value);
+	}
+	// `private _var`. always defined in the current scope
+	void SetPrivate(string name, SQFValue value)
+	{
+		SQFFrame top = Top();
+		if(top) top.SetLocal(name, value);
+	}
+
+	// --- scheduling ---
+
+	// the interpreter has to look at this script before running its next instruction
+	bool IsInterrupted()
+	{
+		return m_Interrupted;
+	}
+	void Interrupt()
+	{
+		m_Interrupted = true;
+	}
+	void ClearInterrupt()
+	{
+		m_Interrupted = false;
+	}
+
+	// suspend until `wakeTime` (System.GetTickCount)
+	void Sleep(int wakeTime)
+	{
+		m_WakeTime = wakeTime;
+		m_State = ESQFScriptState.SLEEPING;
+		m_Interrupted = true;
+	}
+	// give up the remaining slice, continue next frame
+	void Yield()
+	{
+		m_Yield = true;
+		m_Interrupted = true;
+	}
+	// true if the script gave up its slice. clears the request
+	bool ConsumeYield()
+	{
+		bool yielded = m_Yield;
+		m_Yield = false;
+		return yielded;
+	}
+	// wake a sleeping script if its time has come
+	bool TryWake(int now)
+	{
+		if(m_State != ESQFScriptState.SLEEPING) return m_State == ESQFScriptState.RUNNING;
+		if(now < m_WakeTime) return false;
+		m_State = ESQFScriptState.RUNNING;
+		m_Interrupted = false;
+		return true;
+	}
+
+	// --- debugging ---
+
+	// a sleeping script keeps the rest of its sleep for after Resume()
+	void Pause()
+	{
+		if(IsDone() || m_State == ESQFScriptState.PAUSED) return;
+		if(m_State == ESQFScriptState.SLEEPING)
+		{
+			m_SleepLeft = m_WakeTime - System.GetTickCount();
+			if(m_SleepLeft < 0) m_SleepLeft = 0;
+		}
+		m_State = ESQFScriptState.PAUSED;
+		m_Interrupted = true;
+	}
+	void Resume()
+	{
+		if(m_State != ESQFScriptState.PAUSED) return;
+		if(m_SleepLeft >= 0)
+		{
+			Sleep(System.GetTickCount() + m_SleepLeft);
+			m_SleepLeft = -1;
+			return;
+		}
+		m_State = ESQFScriptState.RUNNING;
+	}
+	bool IsPaused()
+	{
+		return m_State == ESQFScriptState.PAUSED;
+	}
+	// paused on a breakpoint, resuming executes the instruction the trap replaced
+	void SkipTrap()
+	{
+		m_SkipTrap = true;
+	}
+	bool IsSkippingTrap()
+	{
+		return m_SkipTrap;
+	}
+	bool ConsumeSkipTrap()
+	{
+		bool skip = m_SkipTrap;
+		m_SkipTrap = false;
+		return skip;
+	}
+	// pause again after `steps` instructions. -1 runs freely. the interrupt flag makes the
+	// interpreter look at this script before every instruction, no other script pays for it
+	void SetStepping(int steps)
+	{
+		m_Steps = steps;
+		if(steps >= 0) m_Interrupted = true;
+	}
+	bool IsStepping()
+	{
+		return m_Steps >= 0;
+	}
+	// false once the steps are used up, which ends stepping
+	bool TakeStep()
+	{
+		if(m_Steps > 0)
+		{
+			m_Steps--;
+			return true;
+		}
+		m_Steps = -1;
+		return false;
+	}
+
+	void Finish(SQFValue result)
+	{
+		m_Result = result;
+		Terminate();
+	}
+	// stop the script. frames and temporaries are released in bulk
+	void Terminate()
+	{
+		m_State = ESQFScriptState.DONE;
+		m_Interrupted = true;
+		m_Frames.Clear();
+		m_Stack.Clear();
+		if(m_Persistent)
+			m_Arena.Reset();
+		else
+			m_Arena.Release();
+	}
+	// run again from scratch, only for persistent scripts
+	void Restart()
+	{
+		m_State = ESQFScriptState.RUNNING;
+		m_Interrupted = false;
+		m_Yield = false;
+		m_SkipTrap = false;
+		m_Steps = -1;
+		m_SleepLeft = -1;
+		m_Result = SQFValue.Nil();
+		m_Frames.Clear();
+		m_Stack.Clear();
+	}
+}
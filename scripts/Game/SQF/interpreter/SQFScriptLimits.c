@@ -0,0 +1,54 @@
+
+
+enum ESQFLimit {
+	SLICE,			// instructions a scheduled script may run per frame
+	UNSCHEDULED,	// instructions a called script may run in total
+	HEAP,			// bytes a script may hold in its arena
+};
+
+// what the interpreter does to a script that hits a limit
+enum ESQFLimitAction {
+	SUSPEND,	// continue next frame. called scripts can't suspend and are terminated instead
+	THROW,		// throw an exception the script can `catch`. a called script that is still over the heap limit
+				// after its catch block is terminated by its next allocation
+	TERMINATE,	// stop the script
+};
+
+// per-script quotas enforced by the interpreter
+class SQFScriptLimits {
+	int m_SliceInstructions = 1000;
+	// Arma stops unscheduled loops after 10,000 iterations, a loop iteration is ~10 instructions
+	int m_UnscheduledInstructions = 100000;
+	int m_MaxHeapBytes = 16 * 1024 * 1024; // 0 for no limit
+
+	ESQFLimitAction m_SliceAction = ESQFLimitAction.SUSPEND;
+	ESQFLimitAction m_UnscheduledAction = ESQFLimitAction.THROW;
+	ESQFLimitAction m_HeapAction = ESQFLimitAction.TERMINATE;
+
+	int Quota(ESQFLimit limit)
+	{
+		switch(limit)
+		{
+			case ESQFLimit.SLICE:
+				return m_SliceInstructions;
+			case ESQFLimit.UNSCHEDULED:
+				return m_UnscheduledInstructions;
+			case ESQFLimit.HEAP:
+				return m_MaxHeapBytes;
+		}
+		return 0;
+	}
+	ESQFLimitAction Action(ESQFLimit limit)
+	{
+		switch(limit)
+		{
+			case ESQFLimit.SLICE:
+				return m_SliceAction;
+			case ESQFLimit.UNSCHEDULED:
+				return m_UnscheduledAction;
+			case ESQFLimit.HEAP:
+				return m_HeapAction;
+		}
+		return ESQFLimitAction.TERMINATE;
+	}
+}
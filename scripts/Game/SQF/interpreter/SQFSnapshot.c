@@ -0,0 +1,511 @@
+
+
+// value encoding in SQFSnapshot. a tag takes the low 4 bits of a word, the payload the rest
+enum ESQFSnapshotTag {
+	NIL,
+	SCALAR,		// payload: number index
+	TRUE,
+	FALSE,
+	STRING,		// payload: string index
+	ARRAY,		// payload: element count, the elements follow
+	CODE,		// payload: string index of the source, compiled again on load
+	REMOVED,	// variable removed since the last save, changes only
+};
+
+// binary image of namespace variables.
+// names and strings go into one string table, so a name or text repeated across thousands of
+// variables is stored once. every value is a tagged word, arrays are followed by their elements.
+// nothing is formatted or parsed as SQF text, which makes this several times faster and smaller
+// than the `str`/`parseSimpleArray` round trip, see Benchmark().
+class SQFSnapshot {
+	static const int MAGIC = 0x46515353; // "SSQF"
+	static const int VERSION = 1;
+	protected static const int TAG_BITS = 4;
+	protected static const int TAG_MASK = 15;
+
+	protected int m_Generation; // full save this belongs to, see SQFSnapshotStore
+	protected bool m_Changes; // only variables changed since the last save
+	protected ref array<string> m_Strings;
+	protected ref map<string, int> m_StringIndices;
+	protected ref array<float> m_Numbers;
+	protected ref array<int> m_Words; // per variable: name string index, then the value
+	protected int m_Variables;
+	protected int m_Skipped;
+
+	protected int m_Cursor; // decoding position in m_Words
+	protected bool m_Failed; // reading hit the end of the file
+
+	void SQFSnapshot(int generation = 0, bool changes = false)
+	{
+		m_Generation = generation;
+		m_Changes = changes;
+		m_Strings = new array<string>();
+		m_StringIndices = new map<string, int>();
+		m_Numbers = new array<float>();
+		m_Words = new array<int>();
+	}
+
+	// every variable of `variables`
+	static SQFSnapshot Capture(SQFNamespace variables, int generation = 0)
+	{
+		SQFSnapshot snapshot = new SQFSnapshot(generation);
+		for(int i = 0; i < variables.Count(); i++)
+			snapshot.Put(variables.NameAt(i), variables.ValueAt(i));
+		return snapshot;
+	}
+
+	// add a variable, null for a removed one. values that can't be saved (script handles, control
+	// structures, final code owned by SQFFunctionLibrary) are skipped and return false. a skipped
+	// variable keeps whatever an earlier save holds for it
+	bool Put(string name, SQFValue value)
+	{
+		if(!value)
+		{
+			if(!m_Changes) return false;
+			m_Words.Insert(intern(name));
+			m_Words.Insert(ESQFSnapshotTag.REMOVED);
+			m_Variables++;
+			return true;
+		}
+		int mark = m_Words.Count();
+		m_Words.Insert(intern(name));
+		if(encode(value))
+		{
+			m_Variables++;
+			return true;
+		}
+		m_Words.Resize(mark);
+		m_Skipped++;
+		return false;
+	}
+
+	// set the variables in `variables` without marking them dirty. final code (functions) is kept.
+	// returns the number restored
+	int Apply(SQFInterpreter vm, SQFNamespace variables)
+	{
+		int restored = 0;
+		m_Cursor = 0;
+		while(m_Cursor < m_Words.Count())
+		{
+			string name = m_Strings[m_Words[m_Cursor]];
+			m_Cursor++;
+			if(m_Words[m_Cursor] == ESQFSnapshotTag.REMOVED)
+			{
+				m_Cursor++;
+				if(variables.Restore(name, null)) restored++;
+				continue;
+			}
+			SQFValue value = decode(vm);
+			if(!value)
+			{
+				Print("failed to restore " + name, LogLevel.ERROR);
+				continue;
+			}
+			value.Promote();
+			if(variables.Restore(name, value)) restored++;
+		}
+		return restored;
+	}
+
+	int Generation()
+	{
+		return m_Generation;
+	}
+	bool IsChanges()
+	{
+		return m_Changes;
+	}
+	int VariableCount()
+	{
+		return m_Variables;
+	}
+	int SkippedCount()
+	{
+		return m_Skipped;
+	}
+	// size once written
+	int Bytes()
+	{
+		int words = 7 + m_Numbers.Count() + m_Words.Count(); // header and counts
+		foreach(string text : m_Strings)
+			words += 1 + (text.Length() + 3) / 4;
+		return words * 4;
+	}
+
+	// --- files ---
+
+	void Write(FileHandle file)
+	{
+		file.Write(MAGIC, 4);
+		file.Write(VERSION, 4);
+		file.Write(m_Generation, 4);
+		int changes = 0;
+		if(m_Changes) changes = 1;
+		file.Write(changes, 4);
+
+		file.Write(m_Strings.Count(), 4);
+		foreach(string text : m_Strings)
+			write_string(file, text);
+		file.Write(m_Numbers.Count(), 4);
+		foreach(float number : m_Numbers)
+			file.Write(number, 4);
+		file.Write(m_Words.Count(), 4);
+		foreach(int word : m_Words)
+			file.Write(word, 4);
+	}
+
+	// the next snapshot in `file`, null at the end of the file or if it's damaged
+	static SQFSnapshot Read(FileHandle file)
+	{
+		int magic;
+		if(file.Read(magic, 4) != 4) return null;
+		SQFSnapshot snapshot = new SQFSnapshot();
+		if(magic != MAGIC || snapshot.read_int(file) != VERSION)
+		{
+			Print("not a SQF snapshot or an unsupported version", LogLevel.ERROR);
+			return null;
+		}
+		if(!snapshot.read_body(file))
+		{
+			Print("SQF snapshot is truncated", LogLevel.ERROR);
+			return null;
+		}
+		return snapshot;
+	}
+
+	// --- benchmark ---
+
+	// time `rounds` save and load round trips of `variables` in memory, binary against `str` and
+	// `parseSimpleArray` of [[name, value], ...]. code can't go through the text route, so that side
+	// leaves code variables out
+	static string Benchmark(SQFInterpreter vm, SQFNamespace variables, int rounds = 10)
+	{
+		int start = System.GetTickCount();
+		int binaryBytes = 0;
+		for(int i = 0; i < rounds; i++)
+		{
+			SQFSnapshot snapshot = Capture(variables);
+			snapshot.Apply(vm, new SQFNamespace("benchmark"));
+			binaryBytes = snapshot.Bytes();
+		}
+		int binaryTime = System.GetTickCount() - start;
+
+		SQFValue pairs = SQFValue.List();
+		for(int j = 0; j < variables.Count(); j++)
+		{
+			SQFValue value = variables.ValueAt(j);
+			if(!is_simple(value)) continue;
+			SQFValue pair = SQFValue.List();
+			pair.m_Array.Insert(SQFValue.Text(variables.NameAt(j)));
+			pair.m_Array.Insert(value);
+			pairs.m_Array.Insert(pair);
+		}
+		SQFSimpleArrayParser parser = new SQFSimpleArrayParser();
+		start = System.GetTickCount();
+		int textBytes = 0;
+		for(int k = 0; k < rounds; k++)
+		{
+			string text = pairs.Stringify();
+			textBytes = text.Length();
+			SQFValue parsed = parser.Parse(text);
+			if(!parsed)
+			{
+				Print(parser.GetErrorMessage(), LogLevel.ERROR);
+				break;
+			}
+			SQFNamespace target = new SQFNamespace("benchmark");
+			foreach(SQFValue restored : parsed.m_Array)
+				target.Restore(restored.m_Array[0].m_String, restored.m_Array[1]);
+		}
+		int textTime = System.GetTickCount() - start;
+
+		return variables.Count().ToString() + " variables, " + rounds.ToString() + " rounds\n"
+			+ "\tbinary: " + binaryTime.ToString() + "ms, " + binaryBytes.ToString() + " bytes\n"
+			+ "\ttext: " + textTime.ToString() + "ms, " + textBytes.ToString() + " bytes (" + pairs.m_Array.Count().ToString() + " variables)";
+	}
+
+	// --- encoding ---
+
+	protected bool encode(SQFValue value)
+	{
+		switch(value.m_Type)
+		{
+			case ESQFValueType.NOTHING:
+				m_Words.Insert(ESQFSnapshotTag.NIL);
+				return true;
+			case ESQFValueType.SCALAR:
+				m_Words.Insert(tagged(ESQFSnapshotTag.SCALAR, m_Numbers.Insert(value.m_Scalar)));
+				return true;
+			case ESQFValueType.BOOL:
+				if(value.m_Bool)
+					m_Words.Insert(ESQFSnapshotTag.TRUE);
+				else
+					m_Words.Insert(ESQFSnapshotTag.FALSE);
+				return true;
+			case ESQFValueType.STRING:
+				m_Words.Insert(tagged(ESQFSnapshotTag.STRING, intern(value.m_String)));
+				return true;
+			case ESQFValueType.ARRAY:
+				m_Words.Insert(tagged(ESQFSnapshotTag.ARRAY, value.m_Array.Count()));
+				foreach(SQFValue element : value.m_Array)
+				{
+					if(!encode(element)) return false;
+				}
+				return true;
+			case ESQFValueType.CODE:
+				if(value.m_Code.IsFinal()) return false;
+				m_Words.Insert(tagged(ESQFSnapshotTag.CODE, intern(value.m_Code.Source())));
+				return true;
+		}
+		return false;
+	}
+
+	protected SQFValue decode(SQFInterpreter vm)
+	{
+		int word = m_Words[m_Cursor];
+		m_Cursor++;
+		int payload = word >> TAG_BITS;
+		switch(word & TAG_MASK)
+		{
+			case ESQFSnapshotTag.NIL:
+				return SQFValue.Nil();
+			case ESQFSnapshotTag.SCALAR:
+				return SQFValue.Scalar(m_Numbers[payload]);
+			case ESQFSnapshotTag.TRUE:
+				return SQFValue.Boolean(true);
+			case ESQFSnapshotTag.FALSE:
+				return SQFValue.Boolean(false);
+			case ESQFSnapshotTag.STRING:
+				return SQFValue.Text(m_Strings[payload]);
+			case ESQFSnapshotTag.ARRAY:
+				// all elements are read even after a failure, the next variable starts behind them
+				SQFValue list = SQFValue.List();
+				bool complete = true;
+				for(int i = 0; i < payload; i++)
+				{
+					SQFValue element = decode(vm);
+					if(!element) complete = false;
+					list.m_Array.Insert(element);
+				}
+				if(!complete) return null;
+				return list;
+			case ESQFSnapshotTag.CODE:
+				SQFCode code = vm.Compile(m_Strings[payload]);
+				if(!code) return null;
+				return SQFValue.Code(code);
+		}
+		return null;
+	}
+
+	protected int intern(string text)
+	{
+		int index;
+		if(m_StringIndices.Find(text, index)) return index;
+		index = m_Strings.Insert(text);
+		m_StringIndices.Insert(text, index);
+		return index;
+	}
+	protected int tagged(ESQFSnapshotTag tag, int payload)
+	{
+		return tag | (payload << TAG_BITS);
+	}
+	// values `parseSimpleArray` can read back
+	protected static bool is_simple(SQFValue value)
+	{
+		switch(value.m_Type)
+		{
+			case ESQFValueType.SCALAR:
+			case ESQFValueType.BOOL:
+			case ESQFValueType.STRING:
+				return true;
+			case ESQFValueType.ARRAY:
+				foreach(SQFValue element : value.m_Array)
+				{
+					if(!is_simple(element)) return false;
+				}
+				return true;
+		}
+		return false;
+	}
+
+	// strings are stored as their length and 4 characters per word
+	protected void write_string(FileHandle file, string text)
+	{
+		int length = text.Length();
+		file.Write(length, 4);
+		for(int i = 0; i < length; i += 4)
+		{
+			int packed = 0;
+			for(int j = 0; j < 4 && i + j < length; j++)
+				packed = packed | ((text.ToAscii(i + j) & 0xFF) << (j * 8));
+			file.Write(packed, 4);
+		}
+	}
+	protected string read_string(FileHandle file)
+	{
+		int length = read_int(file);
+		string text = "";
+		for(int i = 0; i < length && !m_Failed; i += 4)
+		{
+			int packed = read_int(file);
+			for(int j = 0; j < 4 && i + j < length; j++)
+			{
+				int character = (packed >> (j * 8)) & 0xFF;
+				text += character.AsciiToString();
+			}
+		}
+		return text;
+	}
+	protected int read_int(FileHandle file)
+	{
+		int value;
+		if(file.Read(value, 4) != 4) m_Failed = true;
+		return value;
+	}
+	protected bool read_body(FileHandle file)
+	{
+		m_Generation = read_int(file);
+		m_Changes = read_int(file) != 0;
+
+		int strings = read_int(file);
+		for(int i = 0; i < strings && !m_Failed; i++)
+			intern(read_string(file));
+		int numbers = read_int(file);
+		for(int j = 0; j < numbers && !m_Failed; j++)
+		{
+			float number;
+			if(file.Read(number, 4) != 4) m_Failed = true;
+			m_Numbers.Insert(number);
+		}
+		int words = read_int(file);
+		for(int k = 0; k < words && !m_Failed; k++)
+			m_Words.Insert(read_int(file));
+		return !m_Failed;
+	}
+}
+
+// keeps a namespace on disk: a full snapshot at `path` and a journal of changes at `path`.journal.
+// Save() appends only the variables assigned since the previous save to the journal and rewrites
+// the full snapshot once the journal gets long. Load() applies the snapshot, then the journal.
+class SQFSnapshotStore {
+	protected SQFInterpreter m_Interpreter;
+	protected SQFNamespace m_Namespace;
+	protected string m_Path;
+	protected string m_Journal;
+	protected int m_Generation; // of the full snapshot on disk. journal entries of older ones are ignored
+	protected int m_JournalEntries;
+	protected int m_CompactAfter = 32; // journal entries before Save() writes a full snapshot
+
+	protected int m_LastVariables;
+	protected int m_LastBytes;
+	protected int m_LastTime;
+
+	void SQFSnapshotStore(SQFInterpreter interpreter, SQFNamespace variables, string path)
+	{
+		m_Interpreter = interpreter;
+		m_Namespace = variables;
+		m_Path = path;
+		m_Journal = path + ".journal";
+	}
+
+	void SetCompactAfter(int entries)
+	{
+		m_CompactAfter = entries;
+	}
+
+	// write what changed since the last save
+	bool Save()
+	{
+		if(m_Generation == 0 || m_JournalEntries >= m_CompactAfter) return SaveAll();
+
+		int start = System.GetTickCount();
+		array<string> names = new array<string>();
+		m_Namespace.TakeDirty(names);
+		if(names.Count() == 0) return true;
+		SQFSnapshot snapshot = new SQFSnapshot(m_Generation, true);
+		foreach(string name : names)
+			snapshot.Put(name, m_Namespace.Get(name));
+		if(!write(m_Journal, FileMode.APPEND, snapshot))
+		{
+			foreach(string unsaved : names)
+				m_Namespace.MarkDirty(unsaved);
+			return false;
+		}
+		m_JournalEntries++;
+		finished(snapshot, start);
+		return true;
+	}
+	// write a full snapshot and start a new journal
+	bool SaveAll()
+	{
+		int start = System.GetTickCount();
+		array<string> names = new array<string>();
+		m_Namespace.TakeDirty(names);
+		SQFSnapshot snapshot = SQFSnapshot.Capture(m_Namespace, m_Generation + 1);
+		if(!write(m_Path, FileMode.WRITE, snapshot))
+		{
+			foreach(string unsaved : names)
+				m_Namespace.MarkDirty(unsaved);
+			return false;
+		}
+		// the journal belongs to the previous generation now, also if emptying it fails
+		m_Generation++;
+		FileHandle journal = FileIO.OpenFile(m_Journal, FileMode.WRITE);
+		if(journal) journal.Close();
+		m_JournalEntries = 0;
+		finished(snapshot, start);
+		return true;
+	}
+
+	// restore the saved variables. returns how many were restored, -1 if nothing was saved
+	int Load()
+	{
+		FileHandle file = FileIO.OpenFile(m_Path, FileMode.READ);
+		if(!file) return -1;
+		SQFSnapshot snapshot = SQFSnapshot.Read(file);
+		file.Close();
+		if(!snapshot) return -1;
+		m_Generation = snapshot.Generation();
+		int restored = snapshot.Apply(m_Interpreter, m_Namespace);
+
+		m_JournalEntries = 0;
+		FileHandle journal = FileIO.OpenFile(m_Journal, FileMode.READ);
+		if(!journal) return restored;
+		while(true)
+		{
+			SQFSnapshot changes = SQFSnapshot.Read(journal);
+			if(!changes) break;
+			if(changes.Generation() != m_Generation) continue;
+			restored += changes.Apply(m_Interpreter, m_Namespace);
+			m_JournalEntries++;
+		}
+		journal.Close();
+		return restored;
+	}
+
+	string Report()
+	{
+		return m_Namespace.Name() + ": last save " + m_LastVariables.ToString() + " variables, " + m_LastBytes.ToString() + " bytes in "
+			+ m_LastTime.ToString() + "ms, " + m_JournalEntries.ToString() + "/" + m_CompactAfter.ToString() + " journal entries, "
+			+ m_Namespace.DirtyCount().ToString() + " unsaved";
+	}
+
+	protected bool write(string path, FileMode mode, SQFSnapshot snapshot)
+	{
+		FileHandle file = FileIO.OpenFile(path, mode);
+		if(!file)
+		{
+			Print("failed to open snapshot " + path, LogLevel.ERROR);
+			return false;
+		}
+		snapshot.Write(file);
+		file.Close();
+		return true;
+	}
+	protected void finished(SQFSnapshot snapshot, int start)
+	{
+		m_LastVariables = snapshot.VariableCount();
+		m_LastBytes = snapshot.Bytes();
+		m_LastTime = System.GetTickCount() - start;
+	}
+}
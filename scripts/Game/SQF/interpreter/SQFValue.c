@@ -0,0 +1,257 @@
+
+
+// runtime data types. names match the `typeName` command output
+enum ESQFValueType {
+	NOTHING,	// nil
+	SCALAR,		// 1.10
+	BOOL,		// true false
+	STRING,		// "text"
+	ARRAY,		// [1, "two", true]
+	CODE,		// { hint "x" }
+	IF,			// result of `if`
+	WHILE,		// result of `while`
+	FOR,		// result of `for "_i"`
+	SCRIPT,		// handle returned by `spawn`
+	EXCEPTION,	// result of `try`
+};
+
+// a single SQF value. one class for every type keeps the interpreter free of casts
+class SQFValue {
+	ESQFValueType m_Type;
+	float m_Scalar;
+	bool m_Bool;
+	string m_String;
+	ref array<ref SQFValue> m_Array;
+	ref SQFCode m_Code;
+	ref SQFScript m_Script;
+
+	protected SQFArena m_Arena; // script charged for this value, null once promoted
+	protected int m_Bytes;
+	protected bool m_Promoted; // reachable from a global, never charged to a script again
+	protected bool m_Changed; // array changed in place since the last ClearChanged()
+
+	static int s_Changes; // in place changes to promoted arrays, a namespace only looks for them when this moved
+
+	void SQFValue(ESQFValueType type = ESQFValueType.NOTHING)
+	{
+		m_Type = type;
+	}
+	void ~SQFValue()
+	{
+		if(m_Arena) m_Arena.Refund(m_Bytes);
+	}
+
+	// charge heap growth to the running script. strings and arrays are accounted, fixed size values aren't
+	void Account(int bytes)
+	{
+		if(m_Promoted) return;
+		if(!m_Arena)
+		{
+			m_Arena = SQFArena.s_Current;
+			if(!m_Arena) return;
+		}
+		m_Arena.Charge(bytes);
+		m_Bytes += bytes;
+	}
+	// the value escaped into a global. it no longer counts against the script that made it
+	void Promote()
+	{
+		m_Promoted = true;
+		if(m_Arena)
+		{
+			m_Arena.Refund(m_Bytes);
+			m_Arena = null;
+			m_Bytes = 0;
+		}
+		if(m_Type != ESQFValueType.ARRAY) return;
+		foreach(SQFValue element : m_Array)
+			element.Promote();
+	}
+
+	// `pushBack`, `set` and `append` change arrays in place, without assigning the variable holding them.
+	// `element` is the value stored, in a global array it escapes with it
+	void Changed(SQFValue element = null)
+	{
+		m_Changed = true;
+		if(!m_Promoted) return;
+		s_Changes++;
+		if(element) element.Promote();
+	}
+	// true if this array or an array nested in it changed since ClearChanged()
+	bool HasChanged()
+	{
+		if(m_Type != ESQFValueType.ARRAY) return false;
+		if(m_Changed) return true;
+		foreach(SQFValue element : m_Array)
+		{
+			if(element.HasChanged()) return true;
+		}
+		return false;
+	}
+	void ClearChanged()
+	{
+		if(m_Type != ESQFValueType.ARRAY) return;
+		m_Changed = false;
+		foreach(SQFValue element : m_Array)
+			element.ClearChanged();
+	}
+
+	static SQFValue Nil()
+	{
+		return new SQFValue();
+	}
+	static SQFValue Scalar(float value)
+	{
+		SQFValue v = new SQFValue(ESQFValueType.SCALAR);
+		v.m_Scalar = value;
+		return v;
+	}
+	static SQFValue Boolean(bool value)
+	{
+		SQFValue v = new SQFValue(ESQFValueType.BOOL);
+		v.m_Bool = value;
+		return v;
+	}
+	static SQFValue Text(string value)
+	{
+		SQFValue v = new SQFValue(ESQFValueType.STRING);
+		v.m_String = value;
+		v.Account(SQFArena.VALUE_BYTES + value.Length());
+		return v;
+	}
+	static SQFValue List(array<ref SQFValue> values = null)
+	{
+		SQFValue v = new SQFValue(ESQFValueType.ARRAY);
+		if(!values)
+			values = new array<ref SQFValue>();
+		v.m_Array = values;
+		v.Account(SQFArena.VALUE_BYTES + values.Count() * SQFArena.ELEMENT_BYTES);
+		return v;
+	}
+	static SQFValue Code(SQFCode code)
+	{
+		SQFValue v = new SQFValue(ESQFValueType.CODE);
+		v.m_Code = code;
+		return v;
+	}
+
+	bool IsNil()
+	{
+		return m_Type == ESQFValueType.NOTHING;
+	}
+	// true only for a boolean `true`
+	bool IsTrue()
+	{
+		return m_Type == ESQFValueType.BOOL && m_Bool;
+	}
+
+	string TypeName()
+	{
+		switch(m_Type)
+		{
+			case ESQFValueType.NOTHING:
+				return "ANY";
+			case ESQFValueType.SCALAR:
+				return "SCALAR";
+			case ESQFValueType.BOOL:
+				return "BOOL";
+			case ESQFValueType.STRING:
+				return "STRING";
+			case ESQFValueType.ARRAY:
+				return "ARRAY";
+			case ESQFValueType.CODE:
+				return "CODE";
+			case ESQFValueType.IF:
+				return "IF";
+			case ESQFValueType.WHILE:
+				return "WHILE";
+			case ESQFValueType.FOR:
+				return "FOR";
+			case ESQFValueType.SCRIPT:
+				return "SCRIPT";
+			case ESQFValueType.EXCEPTION:
+				return "EXCEPTION";
+		}
+		return "ANY";
+	}
+
+	// `+array` copy. nested arrays are copied too, everything else is shared
+	SQFValue DeepCopy()
+	{
+		if(m_Type != ESQFValueType.ARRAY) return this;
+		SQFValue copy = SQFValue.List();
+		foreach(SQFValue element : m_Array)
+			copy.m_Array.Insert(element.DeepCopy());
+		return copy;
+	}
+
+	// SQF equality. strings compare case insensitive like `==` does in game
+	bool Equals(SQFValue other)
+	{
+		if(!other || other.m_Type != m_Type) return false;
+		switch(m_Type)
+		{
+			case ESQFValueType.NOTHING:
+				return true;
+			case ESQFValueType.SCALAR:
+				return m_Scalar == other.m_Scalar;
+			case ESQFValueType.BOOL:
+				return m_Bool == other.m_Bool;
+			case ESQFValueType.STRING:
+				string a = m_String;
+				string b = other.m_String;
+				a.ToLower();
+				b.ToLower();
+				return a == b;
+			case ESQFValueType.ARRAY:
+				if(m_Array.Count() != other.m_Array.Count()) return false;
+				for(int i = 0; i < m_Array.Count(); i++)
+				{
+					if(!m_Array[i].Equals(other.m_Array[i])) return false;
+				}
+				return true;
+			case ESQFValueType.CODE:
+				return m_Code == other.m_Code;
+			case ESQFValueType.SCRIPT:
+				return m_Script == other.m_Script;
+		}
+		return false;
+	}
+
+	// text representation used by `str`. strings are quoted
+	string Stringify()
+	{
+		switch(m_Type)
+		{
+			case ESQFValueType.NOTHING:
+				return "any";
+			case ESQFValueType.SCALAR:
+				return m_Scalar.ToString();
+			case ESQFValueType.BOOL:
+				if(m_Bool) return "true";
+				return "false";
+			case ESQFValueType.STRING:
+				string copy = m_String;
+				copy.Replace("\"", "\"\"");
+				return "\"" + copy + "\"";
+			case ESQFValueType.ARRAY:
+				string text = "[";
+				for(int i = 0; i < m_Array.Count(); i++)
+				{
+					if(i > 0) text += ",";
+					text += m_Array[i].Stringify();
+				}
+				return text + "]";
+			case ESQFValueType.CODE:
+				return "{" + m_Code.Source() + "}";
+		}
+		return TypeName();
+	}
+
+	// text representation used by `format` and `diag_log`. strings are not quoted
+	string Format()
+	{
+		if(m_Type == ESQFValueType.STRING) return m_String;
+		return Stringify();
+	}
+}
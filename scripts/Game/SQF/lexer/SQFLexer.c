@@ -42,6 +42,14 @@ class SQFLexer {
 		InitDefaults();
 	}
 	
+	// continue lexing `script` from `offset`. lexing is context free, so starting at any token
+	// boundary gives the same tokens as lexing from the start. used to re-lex edits
+	void Seek(string script, int offset)
+	{
+		m_Script = new SQFStringStream(script);
+		m_Script.SetCursor(offset);
+	}
+	
 	// get the next SQF token
 	SQFToken Next() 
 	{
@@ -102,8 +110,9 @@ class SQFLexer {
 		}
 				
 		// no hits, character not handled by lexer (emoji perhaps?)
+		int start = m_Script.Cursor();
 		m_Script.Inc(); // need to inc so we don't infinite loop
-		return new SQFToken(ESQFTokenType.UNEXPECTED, m_Script.Cursor(), nextChar); // unhandled token
+		return new SQFToken(ESQFTokenType.UNEXPECTED, start, nextChar); // unhandled token
 	}
 	
 	
@@ -183,6 +192,7 @@ class SQFLexer {
 			case ">":
 			case "<":
 			case "=":
+			case "!":
 				return true;
 		}
 		return false;
@@ -227,6 +237,7 @@ class SQFLexer {
 					m_Script.Inc();
 				}	
 				flags = ESQFOperatorFlags.AND;
+				break;
 			case "|":
 				string next = m_Script.Peek();
 				if(next != "|")
@@ -239,7 +250,7 @@ class SQFLexer {
 					m_Script.Inc();
 				}
 				flags = ESQFOperatorFlags.OR;
-			
+				break;
 			case ">":
 				string next = m_Script.Peek();
 				if(next == ">")
@@ -256,17 +267,31 @@ class SQFLexer {
 					flags |= ESQFOperatorFlags.EQUALS;
 					m_Script.Inc();
 				}
+				break;
 			case "<":
 				string next = m_Script.Peek();
-				flags = ESQFOperatorFlags.GREATER;	
+				flags = ESQFOperatorFlags.LESS;	
 				if(next == "=")
 				{
 					flags |= ESQFOperatorFlags.EQUALS;
 					m_Script.Inc();
 				}
+				break;
+			case "!":
+				string next = m_Script.Peek();
+				flags = ESQFOperatorFlags.NOT;
+				if(next == "=")
+				{
+					flags |= ESQFOperatorFlags.EQUALS;
+					m_Script.Inc();
+				}
+				break;
 			case "=":
+				// `=` is assignment, `==` is comparison. parser tells them apart by content
 				flags = ESQFOperatorFlags.EQUALS;
-				
+				if(m_Script.Peek() == "=")
+					m_Script.Inc();
+				break;
 			default:
 				return new SQFToken(ESQFTokenType.UNEXPECTED, start, m_Script.GetText(start, m_Script.Cursor() - start));
 		}
@@ -349,14 +374,14 @@ class SQFLexer {
 	protected bool is_boolean_char(string c)
 	{
 		// check if "true"
-		if(m_Script.Cursor() + 4 >= m_Script.Length()) return false;
+		if(m_Script.Cursor() + 4 > m_Script.Length()) return false;
 		
 		string text = m_Script.GetText(m_Script.Cursor(),4);
 		text.ToLower();
 		if(text == "true") return true;
 		
 		// check if "false"
-		if(m_Script.Cursor() + 5 >= m_Script.Length()) return false;
+		if(m_Script.Cursor() + 5 > m_Script.Length()) return false;
 		
 		text = m_Script.GetText(m_Script.Cursor(),5);
 		text.ToLower();
@@ -427,13 +452,100 @@ class SQFLexer {
 	protected SQFToken handleDigit()
 	{
 		// get all characters associated with the digit
-				// logical checks do not apply, "1.1.1.1" would be considered a valid digit in this case
-		// parser will take care of saying "hey malformatted digit!"
+		// logical checks happen once the text is known, "1.1.1.1" is lexed as one malformed number
+		// so the parser can say "hey malformatted digit!"
 		int start = m_Script.Cursor();
 		m_Script.Inc(); // inc off first character
 		bool temp = false;
-		while(is_digit_char(m_Script.Peek(), temp)) m_Script.Inc();
-		return new SQFToken(ESQFTokenType.LITERAL, start, m_Script.GetText(start, m_Script.Cursor() - start), ESQFLiteralFlags.NUMBER);
+		bool hex = false;
+		while(true)
+		{
+			string c = m_Script.Peek();
+			if(c == "x" || c == "X") hex = true;
+			if(is_digit_char(c, temp))
+			{
+				m_Script.Inc();
+				continue;
+			}
+			// exponent sign, 1e-5
+			string previous = m_Script.At(m_Script.Cursor() - 1);
+			if(!hex && (c == "-" || c == "+") && (previous == "e" || previous == "E"))
+			{
+				m_Script.Inc();
+				continue;
+			}
+			break;
+		}
+		string text = m_Script.GetText(start, m_Script.Cursor() - start);
+		float number;
+		if(!decode_number(text, number))
+			return new SQFToken(ESQFTokenType.LITERAL, start, text, ESQFLiteralFlags.NUMBER | ESQFLiteralFlags.MALFORMED);
+		SQFToken token = new SQFToken(ESQFTokenType.LITERAL, start, text, ESQFLiteralFlags.NUMBER);
+		token.SetNumber(number);
+		return token;
+	}
+	// 10, 1.10, 1e10, 1.5e-3, 0x1A. false for anything else
+	protected bool decode_number(string text, out float number)
+	{
+		string lower = text;
+		lower.ToLower();
+		int length = lower.Length();
+		if(length > 2 && lower.Substring(0, 2) == "0x")
+		{
+			number = 0;
+			for(int i = 2; i < length; i++)
+			{
+				int ascii = lower.Get(i).ToAscii();
+				if(ascii >= 48 && ascii <= 57) // 0-9
+					number = number * 16 + ascii - 48;
+				else if(ascii >= 97 && ascii <= 102) // a-f
+					number = number * 16 + ascii - 87;
+				else
+					return false;
+			}
+			return true;
+		}
+
+		// digits [. digits] [e [+-] digits]
+		int position = 0;
+		int digits = skip_decimal(lower, position);
+		if(position < length && lower.Get(position) == ".")
+		{
+			position++;
+			digits += skip_decimal(lower, position);
+		}
+		if(digits == 0) return false;
+		int mantissaLength = position;
+		int exponent = 0;
+		if(position < length && lower.Get(position) == "e")
+		{
+			position++;
+			if(position < length && lower.Get(position) == "+")
+				position++;
+			int exponentStart = position; // keeps a `-` for ToInt
+			if(position < length && lower.Get(position) == "-")
+				position++;
+			if(skip_decimal(lower, position) == 0) return false;
+			exponent = lower.Substring(exponentStart, position - exponentStart).ToInt();
+		}
+		if(position != length) return false;
+		number = lower.Substring(0, mantissaLength).ToFloat();
+		if(exponent != 0)
+			number *= Math.Pow(10, exponent);
+		return true;
+	}
+	// advance past 0-9, returns how many
+	protected int skip_decimal(string text, inout int position)
+	{
+		int count = 0;
+		while(position < text.Length())
+		{
+			int ascii = text.Get(position).ToAscii();
+			if(ascii < 48 || ascii > 57) break;
+			position++;
+			count++;
+		}
+		return count;
 	}
 	
 	// check if char represents a string quote
@@ -471,7 +583,15 @@ class SQFLexer {
 		
 		
 		if(safely_closed)
-			return new SQFToken(ESQFTokenType.LITERAL, start, m_Script.GetText(start, m_Script.Cursor() - start), ESQFLiteralFlags.STRING);
+		{
+			string content = m_Script.GetText(start, m_Script.Cursor() - start);
+			// decode once: drop the quotes, doubled quotes are escapes
+			string text = content.Substring(1, content.Length() - 2);
+			text.Replace(open_character + open_character, open_character);
+			SQFToken token = new SQFToken(ESQFTokenType.LITERAL, start, content, ESQFLiteralFlags.STRING);
+			token.SetText(text);
+			return token;
+		}
 		
 		// this is a special token to tell us we fucked up the string somehow
 		return new SQFToken(ESQFTokenType.UNEXPECTED, start, m_Script.GetText(start, m_Script.Cursor() - start));
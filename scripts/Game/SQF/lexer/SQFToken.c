@@ -27,6 +27,7 @@ enum ESQFLiteralFlags {
 	NUMBER = 2,
 	TRUE = 4,
 	FALSE = 8,
+	MALFORMED = 16, // number that doesn't parse, like 1.1.1.1
 };
 enum ESQFSeparatorFlags {
 	OPEN = 1,
@@ -63,6 +64,8 @@ class SQFToken {
 	protected string m_Content;
 	protected int m_Start;
 	protected int m_Flags;
+	protected float m_Number; // decoded number literal
+	protected string m_Text; // decoded string literal, quotes and escapes removed
 	
 	void SQFToken(ESQFTokenType type, int start, string content, int flags = 0) {
 		this.m_Type = type;
@@ -87,4 +90,35 @@ class SQFToken {
 	int Flags() {
 		return m_Flags;
 	}
+	int Start() {
+		return m_Start;
+	}
+	// offset of the first character after this token
+	int End() {
+		return m_Start + m_Content.Length();
+	}
+	string Content() {
+		return m_Content;
+	}
+	// literal values, decoded once by the lexer
+	float Number() {
+		return m_Number;
+	}
+	void SetNumber(float number) {
+		m_Number = number;
+	}
+	string Text() {
+		return m_Text;
+	}
+	void SetText(string text) {
+		m_Text = text;
+	}
+	// move the token after text was inserted or removed before it
+	void Shift(int delta) {
+		m_Start += delta;
+	}
+	// same token, ignoring position
+	bool Matches(SQFToken other) {
+		return m_Type == other.m_Type && m_Flags == other.m_Flags && m_Content == other.m_Content;
+	}
 }
\ No newline at end of file
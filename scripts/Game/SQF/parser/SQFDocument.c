@@ -0,0 +1,342 @@
+/* SQF Document
+
+A script being edited, e.g. a SQF_ScriptConfig open in Workbench. Keeps the tokens and the compiled
+top level statements of the text so an edit only re-lexes and re-parses what it touched:
+
+	1. re-lex from the end of the last token before the edit. once a new token lands on the
+	   shifted start of an old token after the edit and matches it, the streams are in sync again
+	   (lexing is context free) and the remaining old tokens are kept, shifted by the edit length
+	2. re-split statements from the first statement touching the re-lexed tokens until a statement
+	   boundary lines up with an old one past them. only those statements are parsed again, the
+	   others keep their bytecode. it doesn't depend on offsets
+
+Statement boundaries are `;` and `,` outside of brackets, so typing an unclosed `{` re-parses the
+rest of the script until it is closed, same as a full parse would.
+
+// sample code:
+	SQFDocument document = new SQFDocument(GetScriptEngine().GetInterpreter().Commands(), "_a = 1; _b = 2;");
+	document.Edit(5, 1, "10"); // _a = 10; _b = 2;
+	Print(document.Diagnostics());
+	SQFCode code = GetScriptEngine().GetInterpreter().CompileDocument(document);
+
+*/
+
+
+
+// tokens [m_First, m_End) of a document, including the separator ending the statement
+class SQFStatement {
+	int m_First;
+	int m_End;
+	ref SQFCode m_Code; // null if the statement has errors
+	string m_Error;
+	int m_ErrorOffset = -1; // from the start of the statement, so edits before it don't move the error
+}
+
+class SQFDocument {
+	protected ref SQFParser m_Parser;
+	protected ref SQFLexer m_Lexer;
+
+	protected string m_Source;
+	protected ref array<ref SQFToken> m_Tokens; // comments included, ends with END_OF_SCRIPT
+	protected ref array<ref SQFStatement> m_Statements;
+	protected int m_Errors;
+
+	// work done by the last edit
+	protected int m_RelexedTokens;
+	protected int m_ReparsedStatements;
+
+	void SQFDocument(SQFCommands commands, string source = "")
+	{
+		m_Parser = new SQFParser(commands);
+		m_Lexer = new SQFLexer("");
+		SetText(source);
+	}
+
+	// replace the whole text
+	void SetText(string source)
+	{
+		m_Source = source;
+		m_Tokens = new array<ref SQFToken>();
+		m_Statements = new array<ref SQFStatement>();
+
+		m_Lexer.Seek(source, 0);
+		while(true)
+		{
+			SQFToken token = m_Lexer.Next();
+			m_Tokens.Insert(token);
+			if(token.TokenType() == ESQFTokenType.END_OF_SCRIPT) break;
+		}
+		m_RelexedTokens = m_Tokens.Count();
+		int synced;
+		m_ReparsedStatements = split(0, m_Tokens.Count(), 0, m_Statements, null, synced);
+		countErrors();
+	}
+
+	// replace `removed` characters at `offset` with `inserted`
+	bool Edit(int offset, int removed, string inserted)
+	{
+		int length = m_Source.Length();
+		if(offset < 0 || removed < 0 || offset + removed > length)
+		{
+			Print("invalid edit " + offset.ToString() + "+" + removed.ToString() + " in a " + length.ToString() + " character script", LogLevel.ERROR);
+			return false;
+		}
+		int delta = inserted.Length() - removed;
+		m_Source = m_Source.Substring(0, offset) + inserted + m_Source.Substring(offset + removed, length - offset - removed);
+
+		// the first token touching the edit is the first that can change
+		int first = token_at(offset);
+		int restart = 0;
+		if(first > 0) restart = m_Tokens[first - 1].End();
+
+		// old tokens starting after the removed text are candidates to sync up with
+		int resume = first;
+		while(resume < m_Tokens.Count() && m_Tokens[resume].Start() < offset + removed)
+			resume++;
+
+		array<ref SQFToken> lexed = new array<ref SQFToken>();
+		m_Lexer.Seek(m_Source, restart);
+		while(true)
+		{
+			SQFToken token = m_Lexer.Next();
+			while(resume < m_Tokens.Count() && m_Tokens[resume].Start() + delta < token.Start())
+				resume++;
+			if(resume < m_Tokens.Count() && m_Tokens[resume].Start() + delta == token.Start() && m_Tokens[resume].Matches(token))
+				break; // in sync, the old END_OF_SCRIPT at the latest
+			lexed.Insert(token);
+			if(token.TokenType() == ESQFTokenType.END_OF_SCRIPT)
+			{
+				resume = m_Tokens.Count();
+				break;
+			}
+		}
+		m_RelexedTokens = lexed.Count();
+
+		// splice: kept prefix, re-lexed tokens, shifted suffix
+		array<ref SQFToken> tokens = new array<ref SQFToken>();
+		for(int i = 0; i < first; i++)
+			tokens.Insert(m_Tokens[i]);
+		foreach(SQFToken relexed : lexed)
+			tokens.Insert(relexed);
+		for(int j = resume; j < m_Tokens.Count(); j++)
+		{
+			m_Tokens[j].Shift(delta);
+			tokens.Insert(m_Tokens[j]);
+		}
+		int tokenDelta = lexed.Count() - (resume - first);
+		int changedEnd = first + lexed.Count(); // tokens from here on are old ones
+		m_Tokens = tokens;
+
+		reparse(first, changedEnd, tokenDelta);
+		countErrors();
+		return true;
+	}
+
+	string GetText()
+	{
+		return m_Source;
+	}
+	int TokenCount()
+	{
+		return m_Tokens.Count();
+	}
+	SQFToken TokenAt(int index)
+	{
+		return m_Tokens[index];
+	}
+	int StatementCount()
+	{
+		return m_Statements.Count();
+	}
+	SQFStatement StatementAt(int index)
+	{
+		return m_Statements[index];
+	}
+	int GetRelexedTokens()
+	{
+		return m_RelexedTokens;
+	}
+	int GetReparsedStatements()
+	{
+		return m_ReparsedStatements;
+	}
+
+	int ErrorCount()
+	{
+		return m_Errors;
+	}
+	// one "message @ offset" line per statement with an error
+	string Diagnostics()
+	{
+		string text = "";
+		foreach(SQFStatement statement : m_Statements)
+		{
+			if(statement.m_Code) continue;
+			text += statement.m_Error;
+			int position = ErrorPosition(statement);
+			if(position >= 0) text += " @ " + position.ToString();
+			text += "\n";
+		}
+		return text;
+	}
+
+	// offset of a statement's error in the current text, -1 if it has none
+	int ErrorPosition(SQFStatement statement)
+	{
+		if(statement.m_ErrorOffset < 0) return -1;
+		return m_Tokens[statement.m_First].Start() + statement.m_ErrorOffset;
+	}
+
+	// the whole script as one SQFCode, same as SQFParser.Parse() of the text. null if there are errors
+	SQFCode Link()
+	{
+		if(m_Errors > 0) return null;
+		SQFCode linked = new SQFCode(m_Source);
+		bool empty = true;
+		foreach(SQFStatement statement : m_Statements)
+		{
+			SQFCode code = statement.m_Code;
+			if(code.Size() == 0) continue;
+			if(!empty) linked.Emit(ESQFOpCode.END_STATEMENT);
+			empty = false;
+			// constants move to the pool of the linked code. blocks are copied so the linked
+			// code can be optimized without touching them
+			for(int ip = 0; ip < code.Size(); ip++)
+			{
+				ESQFOpCode op = code.Op(ip);
+				int arg = code.Arg(ip);
+				if(SQFCode.UsesConstant(op))
+					arg = linked.Constants().Import(code.Constant(arg));
+				else if(op == ESQFOpCode.PUSH_CODE)
+					arg = linked.AddBlock(code.Block(arg).CopyInto(linked.Constants()));
+				linked.Emit(op, arg);
+			}
+		}
+		return linked;
+	}
+
+	// re-split statements around the changed tokens [first, changedEnd) and parse the new ones
+	protected void reparse(int first, int changedEnd, int tokenDelta)
+	{
+		// first statement that contains a changed token. the last statement may lack a `;`,
+		// so tokens added after it can still belong to it
+		int count = m_Statements.Count();
+		int affected = 0;
+		while(affected < count && m_Statements[affected].m_End <= first)
+			affected++;
+		if(affected == count && affected > 0)
+			affected--;
+		int start = 0;
+		if(affected < count) start = m_Statements[affected].m_First;
+
+		array<ref SQFStatement> statements = new array<ref SQFStatement>();
+		for(int i = 0; i < affected; i++)
+			statements.Insert(m_Statements[i]);
+
+		// old statements to sync with, in old token indices
+		array<ref SQFStatement> old = new array<ref SQFStatement>();
+		for(int j = affected; j < count; j++)
+			old.Insert(m_Statements[j]);
+
+		int synced = -1;
+		m_ReparsedStatements = split(start, changedEnd, tokenDelta, statements, old, synced);
+		if(synced >= 0)
+		{
+			for(int k = synced; k < old.Count(); k++)
+			{
+				old[k].m_First = old[k].m_First + tokenDelta;
+				old[k].m_End = old[k].m_End + tokenDelta;
+				statements.Insert(old[k]);
+			}
+		}
+		m_Statements = statements;
+	}
+
+	// parse statements from token `start` into `statements`. with `old`, stops at the first boundary
+	// at or after `changedEnd` where an old statement started and returns its index in `synced`.
+	// returns the number of statements parsed
+	protected int split(int start, int changedEnd, int tokenDelta, array<ref SQFStatement> statements, array<ref SQFStatement> old, out int synced)
+	{
+		synced = -1;
+		int parsed = 0;
+		int last = m_Tokens.Count() - 1; // END_OF_SCRIPT
+		int candidate = 0;
+		int position = start;
+		while(position < last)
+		{
+			if(old && position >= changedEnd)
+			{
+				while(candidate < old.Count() && old[candidate].m_First + tokenDelta < position)
+					candidate++;
+				if(candidate < old.Count() && old[candidate].m_First + tokenDelta == position)
+				{
+					synced = candidate;
+					return parsed;
+				}
+			}
+			SQFStatement statement = new SQFStatement();
+			statement.m_First = position;
+			statement.m_End = statement_end(position);
+			statement.m_Code = m_Parser.ParseRange(m_Source, m_Tokens, statement.m_First, statement.m_End);
+			if(!statement.m_Code)
+			{
+				statement.m_Error = m_Parser.GetErrorMessage();
+				// the error can be on the END_OF_SCRIPT the parser adds, which isn't one of ours
+				SQFToken errorToken = m_Parser.GetErrorToken();
+				if(errorToken)
+					statement.m_ErrorOffset = errorToken.Start() - m_Tokens[statement.m_First].Start();
+			}
+			statements.Insert(statement);
+			parsed++;
+			position = statement.m_End;
+		}
+		return parsed;
+	}
+
+	// index after the `;` or `,` ending the statement starting at `position`, or END_OF_SCRIPT
+	protected int statement_end(int position)
+	{
+		int last = m_Tokens.Count() - 1;
+		int depth = 0;
+		for(int i = position; i < last; i++)
+		{
+			SQFToken token = m_Tokens[i];
+			if(token.TokenType() != ESQFTokenType.SEPARATOR) continue;
+			int flags = token.Flags();
+			if(flags & ESQFSeparatorFlags.OPEN)
+				depth++;
+			else if(flags & ESQFSeparatorFlags.CLOSE)
+			{
+				if(depth > 0) depth--;
+			}
+			else if(depth == 0 && (flags & (ESQFSeparatorFlags.SEMICOLON | ESQFSeparatorFlags.COMMA)))
+				return i + 1;
+		}
+		return last;
+	}
+
+	// first token ending at or after `offset`
+	protected int token_at(int offset)
+	{
+		int low = 0;
+		int high = m_Tokens.Count() - 1; // END_OF_SCRIPT always qualifies
+		while(low < high)
+		{
+			int middle = (low + high) / 2;
+			if(m_Tokens[middle].End() < offset)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		return low;
+	}
+
+	protected void countErrors()
+	{
+		m_Errors = 0;
+		foreach(SQFStatement statement : m_Statements)
+		{
+			if(!statement.m_Code) m_Errors++;
+		}
+	}
+}
@@ -0,0 +1,165 @@
+/* SQF Optimizer
+
+Peephole pass over SQFCode emitted by SQFParser. A handful of idioms dominate real mission code,
+each costing 2-4 instruction dispatches; they are fused into single superinstructions:
+
+	_i = _i + 1					GET_VAR, PUSH_NUMBER, CALL_BINARY +, SET_VAR	-> INC_LOCAL
+	_arr pushBack _x			GET_VAR, GET_VAR, CALL_BINARY pushBack			-> GET_VAR, PUSHBACK_LOCAL
+	_x select 0					PUSH_NUMBER, CALL_BINARY select					-> SELECT_CONST
+	count _arr					GET_VAR, CALL_UNARY count						-> COUNT_LOCAL
+	isNil "var"					PUSH_STRING, CALL_UNARY isNil					-> IS_NIL_VAR
+	if (_a) then {}				CALL_UNARY if, PUSH_CODE, CALL_BINARY then		-> IF_THEN
+	if (_a > 0) then {}			CALL_BINARY >, CALL_UNARY if, PUSH_CODE, then	-> IF_COMPARE_THEN
+
+Every pattern only touches values it pushes itself, so fusing never changes evaluation order.
+
+*/
+
+
+
+class SQFOptimizer {
+	protected ref map<int, int> m_Fusions;
+
+	// optimize `code` and its nested blocks in place. fusion counts are stored on `code`
+	void Optimize(SQFCode code)
+	{
+		m_Fusions = new map<int, int>();
+		optimizeBlock(code);
+		code.SetFusions(m_Fusions);
+	}
+
+	// "INC_LOCAL: 3, IF_THEN: 1" style summary of an optimized script
+	static string Report(SQFCode code)
+	{
+		map<int, int> fusions = code.Fusions();
+		if(!fusions || fusions.Count() == 0) return "no fusions";
+		string text = "";
+		for(int i = 0; i < fusions.Count(); i++)
+		{
+			if(i > 0) text += ", ";
+			text += typename.EnumToString(ESQFOpCode, fusions.GetKey(i)) + ": " + fusions.GetElement(i).ToString();
+		}
+		return text;
+	}
+
+	protected void optimizeBlock(SQFCode code)
+	{
+		array<int> output = new array<int>();
+		int size = code.Size();
+		int ip = 0;
+		while(ip < size)
+		{
+			int replaced = fuse(code, ip, output);
+			if(replaced == 0)
+			{
+				output.Insert(code.Op(ip));
+				output.Insert(code.Arg(ip));
+				replaced = 1;
+			}
+			ip += replaced;
+		}
+		code.SetInstructions(output);
+
+		for(int i = 0; i < code.BlockCount(); i++)
+			optimizeBlock(code.Block(i));
+	}
+
+	// try every pattern at `ip`. returns the number of instructions replaced, 0 if nothing matched
+	protected int fuse(SQFCode code, int ip, array<int> output)
+	{
+		int remaining = code.Size() - ip;
+		ESQFOpCode op = code.Op(ip);
+		int arg = code.Arg(ip);
+
+		if(remaining >= 4 && op == ESQFOpCode.CALL_BINARY && is_comparison(arg) && is_if_then(code, ip + 1))
+			return emit(output, ESQFOpCode.IF_COMPARE_THEN, code.Arg(ip + 2) << 8 | arg, 4);
+
+		if(remaining >= 3 && is_if_then(code, ip))
+			return emit(output, ESQFOpCode.IF_THEN, code.Arg(ip + 1), 3);
+
+		if(op == ESQFOpCode.GET_VAR && SQFInterpreter.IsLocal(code.Name(arg)))
+		{
+			// _i = _i + 1, _i = _i - 1
+			if(remaining >= 4 && code.Op(ip + 1) == ESQFOpCode.PUSH_NUMBER && code.Constant(code.Arg(ip + 1)).m_Scalar == 1
+				&& code.Op(ip + 2) == ESQFOpCode.CALL_BINARY && code.Op(ip + 3) == ESQFOpCode.SET_VAR && code.Arg(ip + 3) == arg)
+			{
+				if(code.Arg(ip + 2) == ESQFCommand.PLUS)
+					return emit(output, ESQFOpCode.INC_LOCAL, arg, 4);
+				if(code.Arg(ip + 2) == ESQFCommand.MINUS)
+					return emit(output, ESQFOpCode.DEC_LOCAL, arg, 4);
+			}
+			// _arr pushBack <single value>. the value is pushed first, the array read afterwards
+			if(remaining >= 3 && is_push(code.Op(ip + 1)) && code.Op(ip + 2) == ESQFOpCode.CALL_BINARY && code.Arg(ip + 2) == ESQFCommand.PUSH_BACK)
+			{
+				output.Insert(code.Op(ip + 1));
+				output.Insert(code.Arg(ip + 1));
+				return emit(output, ESQFOpCode.PUSHBACK_LOCAL, arg, 3);
+			}
+			// count _arr
+			if(remaining >= 2 && code.Op(ip + 1) == ESQFOpCode.CALL_UNARY && code.Arg(ip + 1) == ESQFCommand.COUNT)
+				return emit(output, ESQFOpCode.COUNT_LOCAL, arg, 2);
+		}
+
+		// <array> select N
+		if(remaining >= 2 && op == ESQFOpCode.PUSH_NUMBER && code.Op(ip + 1) == ESQFOpCode.CALL_BINARY && code.Arg(ip + 1) == ESQFCommand.SELECT)
+		{
+			float index = code.Constant(arg).m_Scalar;
+			if(index >= 0 && index == Math.Floor(index))
+				return emit(output, ESQFOpCode.SELECT_CONST, index, 2);
+		}
+
+		// isNil "var"
+		if(remaining >= 2 && op == ESQFOpCode.PUSH_STRING && code.Op(ip + 1) == ESQFOpCode.CALL_UNARY && code.Arg(ip + 1) == ESQFCommand.IS_NIL)
+		{
+			string name = code.Name(arg);
+			name.ToLower();
+			return emit(output, ESQFOpCode.IS_NIL_VAR, code.AddString(name), 2);
+		}
+
+		return 0;
+	}
+
+	protected int emit(array<int> output, ESQFOpCode op, int arg, int replaced)
+	{
+		output.Insert(op);
+		output.Insert(arg);
+		m_Fusions.Set(op, m_Fusions.Get(op) + 1);
+		return replaced;
+	}
+
+	// `if`, `{}`, `then` starting at ip
+	protected bool is_if_then(SQFCode code, int ip)
+	{
+		return code.Op(ip) == ESQFOpCode.CALL_UNARY && code.Arg(ip) == ESQFCommand.IF
+			&& code.Op(ip + 1) == ESQFOpCode.PUSH_CODE
+			&& code.Op(ip + 2) == ESQFOpCode.CALL_BINARY && code.Arg(ip + 2) == ESQFCommand.THEN;
+	}
+	// instructions that push exactly one value and have no side effects
+	protected bool is_push(ESQFOpCode op)
+	{
+		switch(op)
+		{
+			case ESQFOpCode.PUSH_NUMBER:
+			case ESQFOpCode.PUSH_STRING:
+			case ESQFOpCode.PUSH_BOOL:
+			case ESQFOpCode.PUSH_CODE:
+			case ESQFOpCode.GET_VAR:
+				return true;
+		}
+		return false;
+	}
+	protected bool is_comparison(int command)
+	{
+		switch(command)
+		{
+			case ESQFCommand.EQUAL:
+			case ESQFCommand.NOT_EQUAL:
+			case ESQFCommand.LESS:
+			case ESQFCommand.GREATER:
+			case ESQFCommand.LESS_EQUAL:
+			case ESQFCommand.GREATER_EQUAL:
+				return true;
+		}
+		return false;
+	}
+}
@@ -1,7 +1,365 @@
+/* SQF Parser
 
+Compiles the token output of SQFLexer into SQFCode bytecode for the interpreter.
+SQF has no statements beyond assignments; everything else is nular, unary or binary commands
+(`if`, `then`, `while` are commands too), so expressions are parsed by precedence climbing
+and emitted in postfix order.
+
+// sample code:
+	SQFParser parser = new SQFParser(new SQFCommands());
+	SQFCode code = parser.Parse("private _a = 1 + 2; diag_log _a;");
+	if(code) Print(code.Disassemble());
+
+*/
 
 
 
 class SQFParser {
-	void SQFParser() {}  // not implemented
-}
\ No newline at end of file
+	protected SQFCommands m_Commands;
+
+	protected ref array<ref SQFToken> m_Tokens;
+	protected int m_Index;
+	protected string m_Source;
+	protected string m_Error;
+	protected string m_ErrorMessage;
+	protected SQFToken m_ErrorToken;
+
+	void SQFParser(SQFCommands commands)
+	{
+		m_Commands = commands;
+	}
+
+	// compile a script. returns null on syntax errors, see GetError()
+	SQFCode Parse(string script)
+	{
+		m_Source = script;
+		m_Error = "";
+		m_Index = 0;
+		m_Tokens = new array<ref SQFToken>();
+
+		SQFCode code = new SQFCode(script);
+		if(!tokenize(script) || !parseStatements(code, false))
+		{
+			Print("failed to parse script: " + m_Error, LogLevel.ERROR);
+			return null;
+		}
+		return code;
+	}
+
+	// compile tokens [first, end) of an already lexed script without printing errors.
+	// `source` is the text the token offsets point into. used by SQFDocument to re-parse single statements
+	SQFCode ParseRange(string source, array<ref SQFToken> tokens, int first, int end)
+	{
+		m_Source = source;
+		m_Error = "";
+		m_Index = 0;
+		m_Tokens = new array<ref SQFToken>();
+
+		int stop = source.Length();
+		if(end < tokens.Count()) stop = tokens[end].Start();
+		for(int i = first; i < end; i++)
+		{
+			SQFToken token = tokens[i];
+			ESQFTokenType type = token.TokenType();
+			if(type == ESQFTokenType.COMMENT) continue;
+			if(type == ESQFTokenType.UNEXPECTED)
+			{
+				error("unexpected '" + token.Content() + "'", token);
+				return null;
+			}
+			if(type == ESQFTokenType.END_OF_SCRIPT) break;
+			m_Tokens.Insert(token);
+		}
+		m_Tokens.Insert(new SQFToken(ESQFTokenType.END_OF_SCRIPT, stop, ""));
+
+		int start = stop;
+		if(first < end) start = tokens[first].Start();
+		SQFCode code = new SQFCode(source.Substring(start, stop - start));
+		if(!parseStatements(code, false)) return null;
+		return code;
+	}
+
+	string GetError()
+	{
+		return m_Error;
+	}
+	// the last error without its position, and the token it was raised at
+	string GetErrorMessage()
+	{
+		return m_ErrorMessage;
+	}
+	SQFToken GetErrorToken()
+	{
+		return m_ErrorToken;
+	}
+
+	// lex the whole script up front, comments are dropped
+	protected bool tokenize(string script)
+	{
+		SQFLexer lexer = new SQFLexer(script);
+		while(true)
+		{
+			SQFToken token = lexer.Next();
+			ESQFTokenType type = token.TokenType();
+			if(type == ESQFTokenType.COMMENT) continue;
+			if(type == ESQFTokenType.UNEXPECTED) return error("unexpected '" + token.Content() + "'", token);
+
+			m_Tokens.Insert(token);
+			if(type == ESQFTokenType.END_OF_SCRIPT) return true;
+		}
+		return false;
+	}
+
+	// statements separated by `;` or `,`. stops at `}` when parsing a block
+	protected bool parseStatements(SQFCode code, bool inBlock)
+	{
+		bool first = true;
+		while(true)
+		{
+			SQFToken token = peek();
+			if(token.TokenType() == ESQFTokenType.END_OF_SCRIPT)
+			{
+				if(inBlock) return error("missing '}'", token);
+				return true;
+			}
+			if(inBlock && is_separator(token, ESQFSeparatorFlags.BRACE | ESQFSeparatorFlags.CLOSE)) return true;
+			if(is_statement_end(token))
+			{
+				next();
+				continue;
+			}
+
+			// the value of the last statement is the result of the code
+			if(!first) code.Emit(ESQFOpCode.END_STATEMENT);
+			first = false;
+			if(!parseStatement(code)) return false;
+
+			token = peek();
+			if(is_statement_end(token) || token.TokenType() == ESQFTokenType.END_OF_SCRIPT) continue;
+			if(inBlock && is_separator(token, ESQFSeparatorFlags.BRACE | ESQFSeparatorFlags.CLOSE)) continue;
+			return error("missing ';'", token);
+		}
+		return false;
+	}
+
+	// `_var = expr`, `private _var = expr`, `private _var` or an expression
+	protected bool parseStatement(SQFCode code)
+	{
+		SQFToken token = peek();
+		bool isPrivate = false;
+		if(token.TokenType() == ESQFTokenType.KEYWORD && lower(token) == "private")
+		{
+			if(peekAt(1).TokenType() != ESQFTokenType.IDENTIFIER) return error("private expects a variable", token);
+			isPrivate = true;
+			next();
+			token = peek();
+		}
+
+		if(token.TokenType() == ESQFTokenType.IDENTIFIER && is_assignment(peekAt(1)))
+		{
+			string name = lower(token);
+			if(isPrivate && name.Get(0) != "_") return error("private global variable '" + token.Content() + "'", token);
+			next(); // name
+			next(); // =
+			if(!parseExpression(code)) return false;
+			if(isPrivate)
+				code.Emit(ESQFOpCode.SET_PRIVATE, code.AddString(name));
+			else
+				code.Emit(ESQFOpCode.SET_VAR, code.AddString(name));
+			return true;
+		}
+		if(isPrivate)
+		{
+			next();
+			code.Emit(ESQFOpCode.CALL_NULAR, ESQFCommand.NIL);
+			code.Emit(ESQFOpCode.SET_PRIVATE, code.AddString(lower(token)));
+			return true;
+		}
+		return parseExpression(code);
+	}
+
+	protected bool parseExpression(SQFCode code)
+	{
+		return parseBinary(code, ESQFPrecedence.OR);
+	}
+
+	// operand followed by any binary commands binding at least as tight as `minPrecedence`
+	protected bool parseBinary(SQFCode code, int minPrecedence)
+	{
+		if(!parseUnary(code)) return false;
+
+		int id;
+		int precedence;
+		SQFToken token = peek();
+		while(binary_at(token, id, precedence) && precedence >= minPrecedence)
+		{
+			next();
+			if(!parseBinary(code, precedence + 1)) return false;
+			code.Emit(ESQFOpCode.CALL_BINARY, id);
+			token = peek();
+		}
+		return true;
+	}
+
+	// a single operand: literal, variable, nular command, unary command + operand, (), [] or {}
+	protected bool parseUnary(SQFCode code)
+	{
+		SQFToken token = next();
+		int id;
+		switch(token.TokenType())
+		{
+			case ESQFTokenType.LITERAL:
+				int flags = token.Flags();
+				if(flags & ESQFLiteralFlags.MALFORMED)
+					return error("malformed number '" + token.Content() + "'", token);
+				if(flags & ESQFLiteralFlags.NUMBER)
+					code.Emit(ESQFOpCode.PUSH_NUMBER, code.AddNumber(token.Number()));
+				else if(flags & ESQFLiteralFlags.STRING)
+					code.Emit(ESQFOpCode.PUSH_STRING, code.AddString(token.Text()));
+				else if(flags & ESQFLiteralFlags.TRUE)
+					code.Emit(ESQFOpCode.PUSH_BOOL, 1);
+				else
+					code.Emit(ESQFOpCode.PUSH_BOOL, 0);
+				return true;
+
+			case ESQFTokenType.SEPARATOR:
+				if(is_separator(token, ESQFSeparatorFlags.PARENTHESES | ESQFSeparatorFlags.OPEN))
+				{
+					if(!parseExpression(code)) return false;
+					if(!is_separator(next(), ESQFSeparatorFlags.PARENTHESES | ESQFSeparatorFlags.CLOSE)) return error("missing ')'", token);
+					return true;
+				}
+				if(is_separator(token, ESQFSeparatorFlags.BRACKET | ESQFSeparatorFlags.OPEN))
+					return parseArray(code);
+				if(is_separator(token, ESQFSeparatorFlags.BRACE | ESQFSeparatorFlags.OPEN))
+					return parseBlock(code, token);
+				break;
+
+			case ESQFTokenType.OPERATOR:
+				if(m_Commands.FindUnary(token.Content(), id))
+				{
+					if(!parseUnary(code)) return false;
+					code.Emit(ESQFOpCode.CALL_UNARY, id);
+					return true;
+				}
+				break;
+
+			case ESQFTokenType.IDENTIFIER:
+			case ESQFTokenType.COMMAND:
+			case ESQFTokenType.KEYWORD:
+				string name = lower(token);
+				if(m_Commands.FindUnary(name, id))
+				{
+					if(!parseUnary(code)) return false;
+					code.Emit(ESQFOpCode.CALL_UNARY, id);
+					return true;
+				}
+				if(m_Commands.FindNular(name, id))
+				{
+					code.Emit(ESQFOpCode.CALL_NULAR, id);
+					return true;
+				}
+				if(token.TokenType() == ESQFTokenType.IDENTIFIER)
+				{
+					code.Emit(ESQFOpCode.GET_VAR, code.AddString(name));
+					return true;
+				}
+				break;
+		}
+		if(token.TokenType() == ESQFTokenType.END_OF_SCRIPT) return error("unexpected end of script", token);
+		return error("unexpected '" + token.Content() + "'", token);
+	}
+
+	// `[a, b, c]`, opening bracket already consumed
+	protected bool parseArray(SQFCode code)
+	{
+		int count = 0;
+		if(is_separator(peek(), ESQFSeparatorFlags.BRACKET | ESQFSeparatorFlags.CLOSE))
+		{
+			next();
+			code.Emit(ESQFOpCode.MAKE_ARRAY, 0);
+			return true;
+		}
+		while(true)
+		{
+			if(!parseExpression(code)) return false;
+			count++;
+			SQFToken token = next();
+			if(is_separator(token, ESQFSeparatorFlags.BRACKET | ESQFSeparatorFlags.CLOSE)) break;
+			if(!is_separator(token, ESQFSeparatorFlags.COMMA)) return error("expected ',' or ']'", token);
+		}
+		code.Emit(ESQFOpCode.MAKE_ARRAY, count);
+		return true;
+	}
+
+	// `{ statements }` compiled into a nested block, opening brace already consumed
+	protected bool parseBlock(SQFCode code, SQFToken open)
+	{
+		SQFCode block = new SQFCode("", code.Constants());
+		if(!parseStatements(block, true)) return false;
+		SQFToken close = next();
+		block.SetSource(m_Source.Substring(open.End(), close.Start() - open.End()));
+		code.Emit(ESQFOpCode.PUSH_CODE, code.AddBlock(block));
+		return true;
+	}
+
+	// --- token helpers ---
+
+	protected SQFToken peek()
+	{
+		return m_Tokens[m_Index];
+	}
+	protected SQFToken peekAt(int offset)
+	{
+		int index = m_Index + offset;
+		if(index >= m_Tokens.Count()) index = m_Tokens.Count() - 1; // END_OF_SCRIPT
+		return m_Tokens[index];
+	}
+	// consume a token. never moves past END_OF_SCRIPT
+	protected SQFToken next()
+	{
+		SQFToken token = m_Tokens[m_Index];
+		if(m_Index < m_Tokens.Count() - 1) m_Index++;
+		return token;
+	}
+	protected bool error(string message, SQFToken token)
+	{
+		m_Error = message + " @ " + token.Start().ToString();
+		m_ErrorMessage = message;
+		m_ErrorToken = token;
+		return false;
+	}
+
+	protected string lower(SQFToken token)
+	{
+		string name = token.Content();
+		name.ToLower();
+		return name;
+	}
+	protected bool is_separator(SQFToken token, int flags)
+	{
+		return token.TokenType() == ESQFTokenType.SEPARATOR && (token.Flags() & flags) == flags;
+	}
+	protected bool is_statement_end(SQFToken token)
+	{
+		return is_separator(token, ESQFSeparatorFlags.SEMICOLON) || is_separator(token, ESQFSeparatorFlags.COMMA);
+	}
+	protected bool is_assignment(SQFToken token)
+	{
+		return token.TokenType() == ESQFTokenType.OPERATOR && token.Content() == "=";
+	}
+	// check if this token is a binary command or operator
+	protected bool binary_at(SQFToken token, out int id, out int precedence)
+	{
+		switch(token.TokenType())
+		{
+			case ESQFTokenType.OPERATOR:
+				return m_Commands.FindBinary(token.Content(), id, precedence);
+			case ESQFTokenType.IDENTIFIER:
+			case ESQFTokenType.COMMAND:
+			case ESQFTokenType.KEYWORD:
+				return m_Commands.FindBinary(lower(token), id, precedence);
+		}
+		return false;
+	}
+}
@@ -0,0 +1,115 @@
+/* SQF Simple Array Parser
+
+Reads the output of `str` back for `parseSimpleArray`: an array of numbers, strings, booleans and
+nested arrays. Nothing is compiled or executed, anything else (code, variables, commands) fails.
+
+// sample code:
+	SQFSimpleArrayParser parser = new SQFSimpleArrayParser();
+	SQFValue value = parser.Parse("[1, -2.5, 'text', [true, false]]");
+	if(!value) Print(parser.GetErrorMessage());
+
+*/
+
+
+
+class SQFSimpleArrayParser {
+	protected ref SQFLexer m_Lexer;
+	protected ref SQFToken m_Token;
+	protected string m_Error;
+
+	void SQFSimpleArrayParser()
+	{
+		m_Lexer = new SQFLexer("");
+	}
+
+	// null if `text` isn't a simple array
+	SQFValue Parse(string text)
+	{
+		m_Error = "";
+		m_Lexer.Seek(text, 0);
+		advance();
+		if(!isSeparator(ESQFSeparatorFlags.OPEN | ESQFSeparatorFlags.BRACKET))
+			return fail("expected [");
+		SQFValue value = parse_value();
+		if(!value) return null;
+		if(m_Token.TokenType() != ESQFTokenType.END_OF_SCRIPT)
+			return fail("unexpected text after the array");
+		return value;
+	}
+
+	string GetErrorMessage()
+	{
+		return m_Error;
+	}
+
+	protected SQFValue parse_value()
+	{
+		if(isSeparator(ESQFSeparatorFlags.OPEN | ESQFSeparatorFlags.BRACKET))
+			return parse_array();
+
+		float sign = 1;
+		if(m_Token.TokenType() == ESQFTokenType.OPERATOR && m_Token.Flags() == ESQFOperatorFlags.MINUS)
+		{
+			sign = -1;
+			advance();
+		}
+		if(m_Token.TokenType() != ESQFTokenType.LITERAL)
+			return fail("unexpected " + m_Token.Stringify());
+
+		int flags = m_Token.Flags();
+		SQFValue value;
+		if(flags & ESQFLiteralFlags.NUMBER)
+		{
+			if(flags & ESQFLiteralFlags.MALFORMED) return fail("malformed number");
+			value = SQFValue.Scalar(sign * m_Token.Number());
+		}
+		else if(sign < 0)
+			return fail("- before a non number");
+		else if(flags & ESQFLiteralFlags.STRING)
+			value = SQFValue.Text(m_Token.Text());
+		else
+			value = SQFValue.Boolean((flags & ESQFLiteralFlags.TRUE) != 0);
+		advance();
+		return value;
+	}
+
+	protected SQFValue parse_array()
+	{
+		advance(); // [
+		SQFValue list = SQFValue.List();
+		if(isSeparator(ESQFSeparatorFlags.CLOSE | ESQFSeparatorFlags.BRACKET))
+		{
+			advance();
+			return list;
+		}
+		while(true)
+		{
+			SQFValue element = parse_value();
+			if(!element) return null;
+			list.m_Array.Insert(element);
+			if(isSeparator(ESQFSeparatorFlags.CLOSE | ESQFSeparatorFlags.BRACKET))
+			{
+				advance();
+				return list;
+			}
+			if(!isSeparator(ESQFSeparatorFlags.COMMA))
+				return fail("expected , or ]");
+			advance();
+		}
+		return null;
+	}
+
+	protected void advance()
+	{
+		m_Token = m_Lexer.Next();
+	}
+	protected bool isSeparator(int flags)
+	{
+		return m_Token.TokenType() == ESQFTokenType.SEPARATOR && m_Token.Flags() == flags;
+	}
+	protected SQFValue fail(string message)
+	{
+		m_Error = "parseSimpleArray: " + message + " @ " + m_Token.Start().ToString();
+		return null;
+	}
+}